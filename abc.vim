@@ -30,6 +30,7 @@ syntax match keyword /\<then\>/ skipwhite
 syntax match keyword /\<local\>/ skipwhite
 syntax match keyword /\<global\>/ skipwhite
 syntax match keyword /\<static\>/ skipwhite
+syntax match keyword /\(\<\(global\|static\|extern\)\s\+\)\@<=thread\>\ze\s\+\h/ skipwhite
 syntax match keyword /\<extern\>/ skipwhite
 syntax match keyword /\<return\>/ skipwhite
 syntax match keyword /\<array\>/ skipwhite
@@ -45,8 +46,11 @@ syntax match keyword /\<case\>/ skipwhite
 syntax match keyword /\<default\>/ skipwhite
 syntax match keyword /\<struct\>/ skipwhite
 syntax match keyword /\<union\>/ skipwhite
+syntax match keyword /\(\<struct\s\+\h\w*\s\+\)\@<=packed\>/ skipwhite
+syntax match keyword /\<alignas\>/ skipwhite
 syntax match keyword /\<enum\>/ skipwhite
 syntax match keyword /\<goto\>/ skipwhite
+syntax match keyword /\(\<return\s\+\)\@<=tail\>\ze\s\+\h/ skipwhite
 
 syntax match literal /\<true\>/ skipwhite
 syntax match literal /\<false\>/ skipwhite
@@ -3,16 +3,21 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <thread>
 #include <vector>
 
 #include "expr/implicitcast.hpp"
+#include "gen/debuginfo.hpp"
 #include "gen/gen.hpp"
+#include "gen/pipeline.hpp"
 #include "gen/print.hpp"
+#include "gen/remark.hpp"
 #include "lexer/lexer.hpp"
 #include "lexer/macro.hpp"
 #include "lexer/reader.hpp"
 #include "parser/parser.hpp"
 #include "type/inittypesystem.hpp"
+#include "util/boundedqueue.hpp"
 
 #ifdef SUPPORT_CC
 #define str(s) #s
@@ -79,6 +84,12 @@ usage(const char *prog, int exit = 1)
     std::cerr << "  -S \t\t\t\tCompile only; do not assemble or link.\n";
     std::cerr << "  -emit-llvm \t\t\tGenerate output files in LLVM formats\n";
     std::cerr << "  -c \t\t\t\tCompile and assemble, but do not link.\n";
+    std::cerr << "  -M \t\t\t\tOnly write the dependencies of the input "
+                 "files\n"
+                 "          \t\t\tas make rules, without compiling them.\n";
+    std::cerr << "  -MM \t\t\t\tLike -M but omit the headers of the ABC "
+                 "include\n"
+                 "          \t\t\tdirectory.\n";
     std::cerr
         << "  -MD \t\t\t\tWrite a dependency file for the compiler output.\n";
     std::cerr
@@ -96,9 +107,72 @@ usage(const char *prog, int exit = 1)
     std::cerr << "\t\t\t\t-O3\tOptimize yet more.\n";
     std::cerr << "\t\t\t\t-Os\tOptimize for size.\n";
     std::cerr << "\t\t\t\t-Oz\tOptimize aggressively for size.\n";
+    std::cerr << "  -g \t\t\t\tGenerate DWARF line tables for debuggers and\n"
+                 "          \t\t\tprofilers.\n";
+    std::cerr << "  -g0 \t\t\t\tDo not generate debug information.\n";
+    std::cerr << "  -fno-omit-frame-pointer \tKeep the frame pointer in all "
+                 "functions,\n"
+                 "          \t\t\te.g. for stack sampling profilers.\n";
+    std::cerr << "  -fomit-frame-pointer \t\tOmit the frame pointer where "
+                 "possible.\n"
+                 "          \t\t\t(default)\n";
+    std::cerr << "  -Rpass=<regex> \t\tReport optimizations done by passes "
+                 "whose\n"
+                 "          \t\t\tname matches <regex>.\n";
+    std::cerr << "  -Rpass-missed=<regex> \t\tReport missed optimizations "
+                 "of matching\n"
+                 "          \t\t\tpasses.\n";
+    std::cerr << "  -Rpass-analysis=<regex> \tReport the analysis of "
+                 "matching passes,\n"
+                 "          \t\t\te.g. why a loop was not vectorized.\n";
+    std::cerr << "  -fsave-optimization-record[=<format>]\n"
+                 "          \t\t\tSave all optimization remarks to "
+                 "<file>.opt.yaml\n"
+                 "          \t\t\tor, with format 'bitstream', "
+                 "<file>.opt.bitstream.\n";
+    std::cerr << "  -passes=<pipeline> \t\tReplace the optimization "
+                 "pipeline, e.g.\n"
+                 "          \t\t\t-passes='default<O2>,loop-unroll'.\n";
+    std::cerr << "  -passes-ep-<point>=<pipeline>\n"
+                 "          \t\t\tInsert passes at an extension point of "
+                 "the\n"
+                 "          \t\t\tdefault pipeline: pipeline-start, "
+                 "peephole,\n"
+                 "          \t\t\tscalar-optimizer-late, "
+                 "vectorizer-start or\n"
+                 "          \t\t\toptimizer-last.\n";
+    std::cerr << "  -fpass-plugin=<plugin> \tLoad passes from an LLVM pass "
+                 "plugin.\n";
+    std::cerr << "  -fparallel-codegen=<n> \tGenerate object code with <n> "
+                 "threads.\n";
+    std::cerr << "  -fincremental-cache=<dir> \tReuse the optimized code of "
+                 "functions\n"
+                 "          \t\t\tthat did not change since the last\n"
+                 "          \t\t\tcompilation, cached in <dir>.\n"
+                 "          \t\t\tThe least recently used entries "
+                 "are\n"
+                 "          \t\t\tremoved above 256 MB. Delete <dir> "
+                 "to\n"
+                 "          \t\t\tclear the cache.\n";
+    std::cerr << "  -fstreaming-codegen \t\tGenerate code for each "
+                 "declaration as soon as\n"
+                 "          \t\t\tit is parsed instead of keeping the "
+                 "AST of\n"
+                 "          \t\t\tthe whole file.\n";
+    std::cerr << "  -fpipelined-codegen \t\tLike -fstreaming-codegen but "
+                 "generate code\n"
+                 "          \t\t\ton a second thread while parsing "
+                 "continues.\n";
     std::cerr << "  -target <architecture> \tSpecify the architecture to build "
                  "for.\n";
     std::cerr << "  -mmcu=<mcu> \t\t\tSelect the MCU to target.\n";
+    std::cerr << "  -mcpu=<cpu> \t\t\tGenerate code for the CPU, 'native' "
+                 "selects\n"
+                 "          \t\t\tthe host CPU and its features.\n";
+    std::cerr << "  -march=<cpu> \t\t\tSame as -mcpu=<cpu>.\n";
+    std::cerr << "  -mattr=<features> \t\tEnable (+) or disable (-) target "
+                 "features,\n"
+                 "          \t\t\te.g. -mattr=+avx2,+fma.\n";
     std::cerr << "  -L <dir> \t\t\tAdd the directory dir to the list of\n"
                  "          \t\t\tdirectories to be searched for libraries\n"
                  "          \t\t\tduring preprocessing.\n";
@@ -108,6 +182,8 @@ usage(const char *prog, int exit = 1)
            "          \t\t\tprevents linking with the shared libraries.  \n"
            "          \t\t\tOn other systems, this option has no effect.\n";
     std::cerr << "  --print-ast \t\t\tPrint code represented by the AST.\n";
+    std::cerr << "  --report-switch \t\tReport how switch statements are "
+                 "lowered.\n";
     std::cerr << "  --help \t\t\tDisplay this information.\n";
     /*
               << "\t\t[ -MD -MP -MT <target> -MF <file>] \n"
@@ -116,6 +192,51 @@ usage(const char *prog, int exit = 1)
     std::exit(exit);
 }
 
+// Writes a make rule for 'target' depending on 'infile' and the files it
+// included. With 'phony' each included file gets an empty rule, so make does
+// not fail if the file is removed.
+static void
+writeDependencies(std::ostream &out, const std::filesystem::path &target,
+                  const std::filesystem::path &infile, bool phony,
+                  bool skipSystemDep = false)
+{
+    std::vector<std::filesystem::path> dep;
+    for (const auto &file : abc::lexer::includedFiles()) {
+	auto rel = file.lexically_relative(abcIncludeDir);
+	if (!skipSystemDep || rel.empty() || *rel.begin() == "..") {
+	    dep.push_back(file);
+	}
+    }
+    out << target.c_str() << ": " << infile.c_str() << " ";
+    for (const auto &file : dep) {
+	out << file.c_str() << " ";
+    }
+    out << "\n";
+    if (phony) {
+	for (const auto &file : dep) {
+	    out << file.c_str() << ":\n";
+	}
+    }
+}
+
+static void
+openInputfile(const char *prog, const std::filesystem::path &path)
+{
+    abc::lexer::init();
+
+    if (!abc::lexer::openInputfile(path.c_str())) {
+	std::cerr << prog << ": error: can not open '" << path.c_str()
+	          << "'\n";
+	std::exit(1);
+    }
+    if (!supportOs.empty()) {
+	abc::lexer::Token macro{abc::lexer::Loc{},
+	                        abc::lexer::TokenKind::IDENTIFIER,
+	                        abc::UStr::create(supportOs)};
+	abc::lexer::macro::defineDirective(macro);
+    }
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -130,15 +251,69 @@ main(int argc, char *argv[])
     bool codegen = true;
     bool createDep = false;
     bool createPhonyDep = false;
+    bool scanDep = false;
+    bool skipSystemDep = false;
     std::filesystem::path depTarget;
     std::filesystem::path depFile;
     bool verbose = false;
     bool staticLink = false;
+    bool streamingCodegen = false;
+    bool pipelinedCodegen = false;
     llvm::OptimizationLevel optLevel = llvm::OptimizationLevel::O0;
 
     for (int i = 1; i < argc; ++i) {
 	if (!strcmp(argv[i], "-static")) {
 	    staticLink = true;
+	} else if (!strcmp(argv[i], "-g")) {
+	    gen::opt::debugInfo = true;
+	} else if (!strcmp(argv[i], "-g0")) {
+	    gen::opt::debugInfo = false;
+	} else if (!strcmp(argv[i], "-fno-omit-frame-pointer")) {
+	    gen::opt::framePointer = true;
+	} else if (!strcmp(argv[i], "-fomit-frame-pointer")) {
+	    gen::opt::framePointer = false;
+	} else if (!strncmp(argv[i], "-Rpass=", 7)) {
+	    gen::opt::remarkPass = argv[i] + 7;
+	} else if (!strncmp(argv[i], "-Rpass-missed=", 14)) {
+	    gen::opt::remarkMissed = argv[i] + 14;
+	} else if (!strncmp(argv[i], "-Rpass-analysis=", 16)) {
+	    gen::opt::remarkAnalysis = argv[i] + 16;
+	} else if (!strcmp(argv[i], "-fsave-optimization-record")) {
+	    gen::opt::optRecordFormat = "yaml";
+	} else if (!strncmp(argv[i], "-fsave-optimization-record=", 27)) {
+	    gen::opt::optRecordFormat = argv[i] + 27;
+	    if (gen::opt::optRecordFormat != "yaml" &&
+	        gen::opt::optRecordFormat != "bitstream") {
+		usage(argv[0]);
+	    }
+	} else if (!strncmp(argv[i], "-passes=", 8)) {
+	    gen::opt::passPipeline = argv[i] + 8;
+	} else if (!strncmp(argv[i], "-passes-ep-", 11)) {
+	    auto eq = strchr(argv[i], '=');
+	    if (!eq) {
+		usage(argv[0]);
+	    }
+	    std::string ep(argv[i] + 11, eq);
+	    if (!gen::isExtensionPoint(ep)) {
+		std::cerr << argv[0] << ": error: unknown extension point '"
+		          << ep << "'\n";
+		std::exit(1);
+	    }
+	    gen::opt::extensionPointPasses.emplace_back(ep, eq + 1);
+	} else if (!strncmp(argv[i], "-fpass-plugin=", 14)) {
+	    gen::opt::passPlugin.push_back(argv[i] + 14);
+	} else if (!strncmp(argv[i], "-fparallel-codegen=", 19)) {
+	    auto n = std::atoi(argv[i] + 19);
+	    if (n < 1) {
+		usage(argv[0]);
+	    }
+	    gen::opt::parallelCodegen = n;
+	} else if (!strncmp(argv[i], "-fincremental-cache=", 20)) {
+	    gen::opt::incrementalCache = argv[i] + 20;
+	} else if (!strcmp(argv[i], "-fstreaming-codegen")) {
+	    streamingCodegen = true;
+	} else if (!strcmp(argv[i], "-fpipelined-codegen")) {
+	    pipelinedCodegen = true;
 	} else if (!strcmp(argv[i], "-emit-llvm")) {
 	    outputFileType = gen::LLVM_FILE;
 	    createExecutable = false;
@@ -152,6 +327,15 @@ main(int argc, char *argv[])
 	} else if (!strncmp(argv[i], "-mmcu=", 6)) {
 	    std::string mcu = argv[i] + 6;
 	    gen::opt::mcu = mcu;
+	} else if (!strncmp(argv[i], "-mcpu=", 6)) {
+	    gen::opt::mcpu = argv[i] + 6;
+	} else if (!strncmp(argv[i], "-march=", 7)) {
+	    gen::opt::mcpu = argv[i] + 7;
+	} else if (!strncmp(argv[i], "-mattr=", 7)) {
+	    if (!gen::opt::mattr.empty()) {
+		gen::opt::mattr += ",";
+	    }
+	    gen::opt::mattr += argv[i] + 7;
 	} else if (argv[i][0] == '-') {
 	    switch (argv[i][1]) {
 	    case '-':
@@ -159,6 +343,8 @@ main(int argc, char *argv[])
 		    usage(argv[0], 0);
 		} else if (!strcmp(argv[i], "--print-ast")) {
 		    printAst = true;
+		} else if (!strcmp(argv[i], "--report-switch")) {
+		    gen::opt::reportSwitch = true;
 		} else if (!strcmp(argv[i], "--emit-llvm")) {
 		    outputFileType = gen::LLVM_FILE;
 		    createExecutable = false;
@@ -253,6 +439,13 @@ main(int argc, char *argv[])
 		default:
 		    usage(argv[0]);
 		    break;
+		case '\0':
+		    scanDep = true;
+		    break;
+		case 'M':
+		    scanDep = true;
+		    skipSystemDep = true;
+		    break;
 		case 'D':
 		    createDep = true;
 		    break;
@@ -289,6 +482,16 @@ main(int argc, char *argv[])
 	std::cerr << argv[0] << ": error: no input files\n";
 	std::exit(1);
     }
+    if (!gen::opt::incrementalCache.empty() && gen::opt::debugInfo) {
+	std::cerr << argv[0] << ": warning: -fincremental-cache is ignored "
+	          << "with -g\n";
+	gen::opt::incrementalCache.clear();
+    } else if (!gen::opt::incrementalCache.empty() && gen::remarksEnabled()) {
+	// remarks also attach source locations, see initDebugInfo()
+	std::cerr << argv[0] << ": warning: -fincremental-cache is ignored "
+	          << "with optimization remarks\n";
+	gen::opt::incrementalCache.clear();
+    }
     if (!outfile.empty()) {
 	if (createExecutable) {
 	    executable = outfile;
@@ -311,8 +514,40 @@ main(int argc, char *argv[])
 	}
     }
 
+    // with -M or -MM all rules go to one file or stdout
+    std::ofstream depStream;
+    std::ostream *depOut = &std::cout;
+    if (scanDep) {
+	codegen = false;
+	createExecutable = false;
+	if (!depFile.empty()) {
+	    depStream.open(depFile);
+	    if (!depStream.good()) {
+		std::cerr << "Could not open file: " << depFile << "\n";
+		std::exit(1);
+	    }
+	    depOut = &depStream;
+	}
+    }
+
     bool useDefaultOutfile = outfile.empty();
     for (std::size_t i = 0; i < infile.size(); ++i) {
+	if (scanDep) {
+	    if (infile[i].extension() != ".abc") {
+		continue;
+	    }
+	    // only the lexer runs, it handles the directives and resolves the
+	    // included files
+	    openInputfile(argv[0], infile[i]);
+	    while (abc::lexer::getToken() != abc::lexer::TokenKind::EOI) {
+	    }
+	    auto target = depTarget.empty()
+	                      ? infile[i].filename().replace_extension("o")
+	                      : depTarget;
+	    writeDependencies(*depOut, target, infile[i], createPhonyDep,
+	                      skipSystemDep);
+	    continue;
+	}
 	if (useDefaultOutfile) {
 	    switch (outputFileType) {
 	    case gen::ASSEMBLY_FILE:
@@ -370,19 +605,8 @@ main(int argc, char *argv[])
 
 	abc::initTypeSystem();
 	gen::init(infile[i].stem().c_str(), optLevel);
-	abc::lexer::init();
-
-	if (!abc::lexer::openInputfile(infile[i].c_str())) {
-	    std::cerr << argv[0] << ": error: can not open '"
-	              << infile[i].c_str() << "'\n";
-	    std::exit(1);
-	}
-	if (!supportOs.empty()) {
-	    abc::lexer::Token macro{abc::lexer::Loc{},
-	                            abc::lexer::TokenKind::IDENTIFIER,
-	                            abc::UStr::create(supportOs)};
-	    abc::lexer::macro::defineDirective(macro);
-	}
+	gen::initDebugInfo(infile[i].c_str());
+	openInputfile(argv[0], infile[i]);
 
 	if (verbose) {
 	    std::cerr << argv[0];
@@ -403,15 +627,75 @@ main(int argc, char *argv[])
 	    std::cerr << infile[i].c_str();
 	    std::cerr << " -o " << outfile.c_str() << "\n";
 	}
-	if (auto ast = abc::parser()) {
+	auto handle = [=](abc::Ast *ast) {
 	    if (printAst) {
 		ast->print();
 	    }
 	    if (codegen) {
 		ast->codegen();
-		gen::print(outfile.c_str(), outputFileType);
-		if (outputFileType == gen::OBJECT_FILE) {
-		    objFile.push_back(outfile);
+	    }
+	};
+	auto handleDecl = [=](abc::Ast *decl) {
+	    handle(decl);
+	    if (printAst) {
+		std::cerr << "\n";
+	    }
+	};
+	bool parsed = false;
+	if (pipelinedCodegen) {
+	    // declarations are parsed by this thread and generated by a
+	    // second one, the queue limits how far the parser runs ahead
+	    abc::BoundedQueue<std::shared_ptr<abc::Ast>> queue{64};
+	    std::thread codegenThread{[&] {
+		while (auto decl = queue.pop()) {
+		    std::lock_guard lock{gen::llvmContextMutex};
+		    handleDecl(decl->get());
+		}
+	    }};
+	    parsed = abc::parser([&](std::shared_ptr<abc::Ast> decl) {
+		queue.push(std::move(decl));
+	    });
+	    queue.close();
+	    codegenThread.join();
+	} else if (streamingCodegen) {
+	    // each declaration is generated and released once it is parsed
+	    parsed = abc::parser([=](std::shared_ptr<abc::Ast> decl) {
+		handleDecl(decl.get());
+	    });
+	} else if (auto ast = abc::parser()) {
+	    handle(ast.get());
+	    parsed = true;
+	}
+	if (parsed) {
+	    if (codegen) {
+		// for an executable the record goes to the current directory
+		auto recordPath = createExecutable ? infile[i].filename()
+		                                   : outfile;
+		auto recordExt = "opt." + gen::opt::optRecordFormat;
+		recordPath.replace_extension(recordExt);
+		auto obj =
+		    gen::print(outfile.c_str(), outputFileType, recordPath);
+		if (obj.size() > 1 && !createExecutable) {
+		    // partitions of parallel code generation are combined
+		    // into one relocatable object file
+		    std::string ldCmd = ccCmd + " -r -nostdlib -o ";
+		    ldCmd += outfile.c_str();
+		    for (const auto &part : obj) {
+			ldCmd += " ";
+			ldCmd += part.c_str();
+		    }
+		    if (verbose) {
+			std::cerr << ldCmd.c_str() << "\n";
+		    }
+		    bool linked = !std::system(ldCmd.c_str());
+		    for (const auto &part : obj) {
+			std::filesystem::remove(part);
+		    }
+		    if (!linked) {
+			std::exit(1);
+		    }
+		} else {
+		    objFile.insert(objFile.end(), obj.begin(), obj.end());
 		}
 	    }
 	} else {
@@ -431,16 +715,7 @@ main(int argc, char *argv[])
 	    if (depTarget.empty()) {
 		depTarget = outfile;
 	    }
-	    fs << depTarget.c_str() << ": " << infile[i].c_str() << " ";
-	    for (const auto &file : abc::lexer::includedFiles()) {
-		fs << file.c_str() << " ";
-	    }
-	    fs << "\n";
-	    if (createPhonyDep) {
-		for (const auto &file : abc::lexer::includedFiles()) {
-		    fs << file.c_str() << ":\n";
-		}
-	    }
+	    writeDependencies(fs, depTarget, infile[i], createPhonyDep);
 	}
     }
 
@@ -1,12 +1,19 @@
 #include <iostream>
+#include <map>
 #include <unordered_map>
+#include <unordered_set>
 
+#include "expr/callexpr.hpp"
 #include "expr/compoundexpr.hpp"
 #include "expr/expr.hpp"
+#include "expr/identifier.hpp"
 #include "expr/implicitcast.hpp"
+#include "gen/debuginfo.hpp"
 #include "gen/function.hpp"
 #include "gen/instruction.hpp"
 #include "gen/label.hpp"
+#include "gen/loop.hpp"
+#include "gen/multiversion.hpp"
 #include "gen/variable.hpp"
 #include "lexer/error.hpp"
 #include "type/enumtype.hpp"
@@ -26,6 +33,13 @@ unusedFilter(UStr name)
     return name;
 }
 
+// source location of the following instructions for debug information
+static void
+setDebugLocation(const lexer::Loc &loc)
+{
+    gen::debugLocation(loc.path.c_str(), loc.from.line, loc.from.col);
+}
+
 static std::function<bool(Ast *)>
 createSetBreakLabel(gen::Label breakLabel)
 {
@@ -85,6 +99,10 @@ createSetGotoLabel(const std::unordered_map<UStr, gen::Label> &label)
 {
     return [&](Ast *ast) -> bool {
 	if (auto astLabel = dynamic_cast<AstGoto *>(ast)) {
+	    if (astLabel->expr) {
+		// target is computed
+		return true;
+	    }
 	    if (!label.contains(astLabel->labelName)) {
 		error::location(astLabel->loc);
 		error::out() << error::setColor(error::BOLD) << astLabel->loc
@@ -261,8 +279,6 @@ AstFuncDef::appendParamName(std::vector<lexer::Token> &&fnParamName_)
 void
 AstFuncDef::appendBody(AstPtr &&body_)
 {
-    std::unordered_map<UStr, gen::Label> label;
-
     assert(!body);
     body = std::move(body_);
     body->apply(createSetReturnType(fnType->retType()));
@@ -273,6 +289,13 @@ AstFuncDef::appendBody(AstPtr &&body_)
 void
 AstFuncDef::print(int indent) const
 {
+    if (!targetClones.empty()) {
+	error::out(indent) << "@target_clones(";
+	for (std::size_t i = 0; i < targetClones.size(); ++i) {
+	    error::out() << (i ? ", " : "") << '"' << targetClones[i] << '"';
+	}
+	error::out() << ")\n";
+    }
     error::out(indent) << "fn " << fnName.val << "(";
     for (std::size_t i = 0; i < fnType->paramType().size(); ++i) {
 	error::out() << unusedFilter(fnParamName[i].val);
@@ -296,6 +319,40 @@ AstFuncDef::print(int indent) const
     error::out(indent) << "}";
 }
 
+// If all return statements return the same local variable this variable can
+// be stored in the return slot. Returns the id of this variable, otherwise an
+// empty UStr.
+static UStr
+findNamedReturnValue(Ast *body, const Type *retType)
+{
+    std::unordered_set<UStr> localId;
+    UStr retId;
+    bool found = true;
+    body->apply([&](Ast *ast) -> bool {
+	if (auto localVar = dynamic_cast<AstLocalVar *>(ast)) {
+	    for (const auto &item : localVar->declList->node) {
+		auto var = dynamic_cast<const AstVar *>(item.get());
+		assert(var);
+		for (std::size_t i = 0; i < var->count(); ++i) {
+		    if (!var->getAlignment()) {
+			localId.insert(var->getId(i));
+		    }
+		}
+	    }
+	} else if (auto astReturn = dynamic_cast<AstReturn *>(ast)) {
+	    auto ident = dynamic_cast<const Identifier *>(astReturn->expr.get());
+	    if (!ident || !Type::equals(ident->type, retType) ||
+	        (retId.c_str() && retId != ident->id)) {
+		found = false;
+	    } else {
+		retId = ident->id;
+	    }
+	}
+	return true;
+    });
+    return found && localId.contains(retId) ? retId : UStr{};
+}
+
 void
 AstFuncDef::codegen()
 {
@@ -303,6 +360,17 @@ AstFuncDef::codegen()
 	return;
     }
     gen::functionDefinitionBegin(fnId.c_str(), fnType, fnParamId, false);
+    gen::debugInfoFunctionBegin(fnName.loc.path.c_str(), fnName.loc.from.line);
+    for (const auto &[name, l] : label) {
+	gen::declareLabel(name.c_str(), l);
+    }
+    if (body && gen::hasReturnSlot(fnType)) {
+	auto retId = findNamedReturnValue(body.get(), fnType->retType());
+	if (retId.c_str()) {
+	    gen::localVariableReference(retId.c_str(),
+	                                gen::returnValueAddress());
+	}
+    }
     if (body) {
 	body->codegen();
     }
@@ -317,6 +385,29 @@ AstFuncDef::codegen()
 	    << error::setColor(error::NORMAL);
 	error::fatal();
     }
+    if (targetClones.empty()) {
+	return;
+    }
+    if (!gen::supportsTargetClones()) {
+	error::location(fnName.loc);
+	error::out() << error::setColor(error::BOLD) << fnName.loc << ": "
+	             << error::setColor(error::BOLD_BLUE)
+	             << "warning: " << error::setColor(error::BOLD)
+	             << "'@target_clones' is not supported for this target and "
+	             << "ignored\n"
+	             << error::setColor(error::NORMAL);
+	return;
+    }
+    auto msg = gen::targetClones(fnId.c_str(), targetClones);
+    if (!msg.empty()) {
+	error::location(fnName.loc);
+	error::out() << error::setColor(error::BOLD) << fnName.loc << ": "
+	             << error::setColor(error::BOLD_RED)
+	             << "error: " << error::setColor(error::BOLD)
+	             << "'@target_clones': " << msg << "\n"
+	             << error::setColor(error::NORMAL);
+	error::fatal();
+    }
 }
 
 /*
@@ -341,14 +432,15 @@ AstInitializerExpr::print(int indent) const
  */
 AstVar::AstVar(lexer::Token varName, lexer::Loc varTypeLoc, const Type *varType,
                bool define)
-    : varType{1}, varDeclType{varType}, varName{varName}, varTypeLoc{varTypeLoc}
+    : varType{1}, varDeclType{varType}, alignment{0}, varName{varName},
+      varTypeLoc{varTypeLoc}
 {
     init(define);
 }
 
 AstVar::AstVar(std::vector<lexer::Token> &&varName, lexer::Loc varTypeLoc,
                const Type *varType, bool define)
-    : varType{varName.size()}, varDeclType{varType},
+    : varType{varName.size()}, varDeclType{varType}, alignment{0},
       varName{std::move(varName)}, varTypeLoc{varTypeLoc}
 {
     init(define);
@@ -404,8 +496,8 @@ AstVar::addInitializerExpr(AstInitializerExprPtr &&initializerExpr_)
 		error::fatal();
 	    }
 	    for (std::size_t i = 0; i < varName.size(); ++i) {
-		assert(compExpr->expr[i]);
-		varType[i] = compExpr->expr[i]->type;
+		assert(compExpr->element(i));
+		varType[i] = compExpr->element(i)->type;
 		auto addDecl = Symtab::addDefinition(
 		    varName[i].loc, varName[i].val, varType[i]);
 		assert(addDecl.first);
@@ -444,6 +536,18 @@ AstVar::getType(std::size_t index) const
     return varType[index];
 }
 
+void
+AstVar::setAlignment(std::size_t alignment)
+{
+    this->alignment = alignment;
+}
+
+std::size_t
+AstVar::getAlignment() const
+{
+    return alignment;
+}
+
 void
 AstVar::setExternalLinkage()
 {
@@ -468,7 +572,10 @@ AstVar::setLinkage()
     for (std::size_t i = 0; i < varEntry.size(); ++i) {
 	varEntry[i]->setLinkage();
 	varId[i] = varEntry[i]->getId();
-	gen::globalVariableDefinition(varId[i].c_str(), varType[i]);
+	// called by the parser, see AstLabel::AstLabel()
+	std::lock_guard lock{gen::llvmContextMutex};
+	gen::globalVariableDefinition(varId[i].c_str(), varType[i], nullptr,
+	                              varEntry[i]->isThreadLocal(), alignment);
     }
 }
 
@@ -487,7 +594,27 @@ AstVar::setInternalLinkage()
 	    error::fatal();
 	}
 	varId[i] = varEntry[i]->getId();
-	gen::globalVariableDefinition(varId[i].c_str(), varType[i]);
+	// called by the parser, see AstLabel::AstLabel()
+	std::lock_guard lock{gen::llvmContextMutex};
+	gen::globalVariableDefinition(varId[i].c_str(), varType[i], nullptr,
+	                              varEntry[i]->isThreadLocal(), alignment);
+    }
+}
+
+void
+AstVar::setThreadLocal(bool threadLocal)
+{
+    for (std::size_t i = 0; i < varEntry.size(); ++i) {
+	if (!varEntry[i]->setThreadLocal(threadLocal)) {
+	    error::location(varName[i].loc);
+	    error::out() << error::setColor(error::BOLD) << varName[i].loc
+	                 << ": " << error::setColor(error::BOLD_RED)
+	                 << "error: " << error::setColor(error::BOLD) << "'"
+	                 << varName[i].val << "' can not be re-declared "
+	                 << (threadLocal ? "as" : "without") << " thread\n"
+	                 << error::setColor(error::NORMAL);
+	    error::fatal();
+	}
     }
 }
 
@@ -514,6 +641,9 @@ AstVar::print(int indent) const
     } else {
 	error::out(indent) << varDeclType;
     }
+    if (alignment) {
+	error::out() << " alignas(" << alignment << ")";
+    }
     if (initializerExpr) {
 	error::out() << " = ";
 	initializerExpr->print(0);
@@ -523,11 +653,12 @@ AstVar::print(int indent) const
 /*
  * AstExternVar
  */
-AstExternVar::AstExternVar(AstListPtr &&declList)
-    : declList{std::move(declList)}
+AstExternVar::AstExternVar(AstListPtr &&declList, bool threadLocal)
+    : declList{std::move(declList)}, threadLocal{threadLocal}
 {
     for (auto &decl : this->declList->node) {
 	auto var = dynamic_cast<AstVar *>(decl.get());
+	var->setThreadLocal(threadLocal);
 	var->setExternalLinkage();
     }
 }
@@ -535,7 +666,7 @@ AstExternVar::AstExternVar(AstListPtr &&declList)
 void
 AstExternVar::print(int indent) const
 {
-    error::out(indent) << "extern ";
+    error::out(indent) << (threadLocal ? "extern thread " : "extern ");
     if (declList->size() > 1) {
 	error::out() << "\n";
 	for (std::size_t i = 0; const auto &decl : declList->node) {
@@ -565,7 +696,8 @@ AstExternVar::codegen()
 	for (std::size_t i = 0; i < var->count(); ++i) {
 	    const auto &id = var->getId(i);
 	    const auto &ty = var->getType(i);
-	    if (!gen::externalVariableDeclaration(id.c_str(), ty)) {
+	    if (!gen::externalVariableDeclaration(id.c_str(), ty,
+	                                          threadLocal)) {
 		const auto &tok = var->varName[i];
 		error::location(tok.loc);
 		error::out() << error::setColor(error::BOLD) << tok.loc << ": "
@@ -586,15 +718,19 @@ AstExternVar::codegen()
 /*
  * AstGlobalVar
  */
-AstGlobalVar::AstGlobalVar(AstListPtr &&declList)
-    : declList{std::move(declList)}
+AstGlobalVar::AstGlobalVar(AstListPtr &&declList, bool threadLocal)
+    : declList{std::move(declList)}, threadLocal{threadLocal}
 {
+    for (auto &decl : this->declList->node) {
+	auto var = dynamic_cast<AstVar *>(decl.get());
+	var->setThreadLocal(threadLocal);
+    }
 }
 
 void
 AstGlobalVar::print(int indent) const
 {
-    error::out(indent) << "global ";
+    error::out(indent) << (threadLocal ? "global thread " : "global ");
     if (declList->size() > 1) {
 	error::out() << "\n";
 	for (std::size_t i = 0; const auto &item : declList->node) {
@@ -622,11 +758,13 @@ AstGlobalVar::codegen()
 	auto var = dynamic_cast<const AstVar *>(item.get());
 	if (var->count() == 1) {
 	    gen::globalVariableDefinition(var->getId(0).c_str(),
-	                                  var->getType(0));
+	                                  var->getType(0), nullptr,
+	                                  threadLocal, var->getAlignment());
 	} else {
 	    for (std::size_t i = 0; i < var->count(); ++i) {
 		gen::globalVariableDefinition(var->getId(i).c_str(),
-		                              var->getType(i));
+		                              var->getType(i), nullptr,
+		                              threadLocal, var->getAlignment());
 	    }
 	}
     }
@@ -650,7 +788,8 @@ AstGlobalVar::codegen()
 	    auto initialValue =
 	        initializer ? initializer->loadConstant() : nullptr;
 	    gen::globalVariableDefinition(var->getId(0).c_str(),
-	                                  var->getType(0), initialValue);
+	                                  var->getType(0), initialValue,
+	                                  threadLocal, var->getAlignment());
 	} else {
 	    auto compExpr = dynamic_cast<const CompoundExpr *>(initializer);
 	    assert(!initializer || compExpr);
@@ -658,7 +797,8 @@ AstGlobalVar::codegen()
 		auto initialValue =
 		    initializer ? compExpr->loadConstant(i) : nullptr;
 		gen::globalVariableDefinition(var->getId(i).c_str(),
-		                              var->getType(i), initialValue);
+		                              var->getType(i), initialValue,
+		                              threadLocal, var->getAlignment());
 	    }
 	}
     }
@@ -667,11 +807,12 @@ AstGlobalVar::codegen()
 /*
  * AstStaticVar
  */
-AstStaticVar::AstStaticVar(AstListPtr &&declList)
-    : declList{std::move(declList)}
+AstStaticVar::AstStaticVar(AstListPtr &&declList, bool threadLocal)
+    : declList{std::move(declList)}, threadLocal{threadLocal}
 {
     for (auto &decl : this->declList->node) {
 	auto var = dynamic_cast<AstVar *>(decl.get());
+	var->setThreadLocal(threadLocal);
 	var->setInternalLinkage();
     }
 }
@@ -679,7 +820,7 @@ AstStaticVar::AstStaticVar(AstListPtr &&declList)
 void
 AstStaticVar::print(int indent) const
 {
-    error::out(indent) << "static ";
+    error::out(indent) << (threadLocal ? "static thread " : "static ");
     if (declList->size() > 1) {
 	error::out() << "\n";
 	for (std::size_t i = 0; const auto &item : declList->node) {
@@ -707,11 +848,13 @@ AstStaticVar::codegen()
 	auto var = dynamic_cast<const AstVar *>(item.get());
 	if (var->count() == 1) {
 	    gen::globalVariableDefinition(var->getId(0).c_str(),
-	                                  var->getType(0));
+	                                  var->getType(0), nullptr,
+	                                  threadLocal, var->getAlignment());
 	} else {
 	    for (std::size_t i = 0; i < var->count(); ++i) {
 		gen::globalVariableDefinition(var->getId(i).c_str(),
-		                              var->getType(i));
+		                              var->getType(i), nullptr,
+		                              threadLocal, var->getAlignment());
 	    }
 	}
     }
@@ -732,14 +875,16 @@ AstStaticVar::codegen()
 	    auto initialValue =
 	        initializer ? initializer->loadConstant() : nullptr;
 	    gen::globalVariableDefinition(var->getId(0).c_str(),
-	                                  var->getType(0), initialValue);
+	                                  var->getType(0), initialValue,
+	                                  threadLocal, var->getAlignment());
 	} else {
 	    auto compExpr = dynamic_cast<const CompoundExpr *>(initializer);
 	    assert(compExpr);
 	    for (std::size_t i = 0; i < var->count(); ++i) {
 		gen::globalVariableDefinition(var->getId(i).c_str(),
 		                              var->getType(i),
-		                              compExpr->loadConstant(i));
+		                              compExpr->loadConstant(i),
+		                              threadLocal, var->getAlignment());
 	    }
 	}
     }
@@ -781,25 +926,32 @@ AstLocalVar::codegen()
     for (const auto &item : declList->node) {
 	auto var = dynamic_cast<const AstVar *>(item.get());
 	assert(var);
+	setDebugLocation(var->varName[0].loc);
 	auto initializer = var->getInitializerExpr();
 	if (var->count() == 1) {
-	    gen::localVariableDefinition(var->getId(0).c_str(),
-	                                 var->getType(0));
-	    if (initializer) {
-		gen::store(initializer->loadValue(),
-		           gen::loadAddress(var->getId(0).c_str()));
+	    auto addr = gen::localVariableDefinition(
+	        var->getId(0).c_str(), var->getType(0), var->getAlignment());
+	    auto compExpr = dynamic_cast<const CompoundExpr *>(initializer);
+	    auto callExpr = dynamic_cast<const CallExpr *>(initializer);
+	    if (compExpr) {
+		compExpr->initialize(addr);
+	    } else if (callExpr) {
+		callExpr->initialize(addr);
+	    } else if (initializer) {
+		initializer->storeValue(addr);
 	    }
 	} else {
 	    auto compExpr = dynamic_cast<const CompoundExpr *>(initializer);
 	    assert(!initializer || compExpr);
 	    for (std::size_t i = 0; i < var->count(); ++i) {
 		gen::localVariableDefinition(var->getId(i).c_str(),
-		                             var->getType(i));
+		                             var->getType(i),
+		                             var->getAlignment());
 	    }
 	    for (std::size_t i = 0; i < var->count(); ++i) {
 		if (initializer) {
-		    gen::store(compExpr->loadValue(i),
-		               gen::loadAddress(var->getId(i).c_str()));
+		    compExpr->initialize(
+		        i, gen::loadAddress(var->getId(i).c_str()));
 		}
 	    }
 	}
@@ -809,8 +961,8 @@ AstLocalVar::codegen()
 /*
  * AstReturn
  */
-AstReturn::AstReturn(lexer::Loc loc, ExprPtr &&expr)
-    : loc{loc}, expr{std::move(expr)}
+AstReturn::AstReturn(lexer::Loc loc, ExprPtr &&expr, bool tailCall)
+    : loc{loc}, expr{std::move(expr)}, tailCall{tailCall}
 {
 }
 
@@ -818,6 +970,9 @@ void
 AstReturn::print(int indent) const
 {
     error::out(indent) << "return";
+    if (tailCall) {
+	error::out() << " tail";
+    }
     if (expr) {
 	error::out() << " " << expr;
     }
@@ -833,6 +988,11 @@ AstReturn::codegen()
 	error::out() << loc << ": warning: return statement not reachabel\n";
 	return;
     }
+    setDebugLocation(loc);
+    if (tailCall) {
+	codegenTailCall();
+	return;
+    }
     if (retType->isVoid()) {
 	if (expr) {
 	    error::location(expr->loc);
@@ -857,8 +1017,50 @@ AstReturn::codegen()
 	    return;
 	}
 	expr = ImplicitCast::create(std::move(expr), retType);
-	gen::returnInstruction(expr->loadValue());
+	// the value is stored where the return value is expected, unless it
+	// is already there (see findNamedReturnValue())
+	auto retAddr = gen::returnValueAddress();
+	auto ident = dynamic_cast<const Identifier *>(expr.get());
+	auto callExpr = dynamic_cast<const CallExpr *>(expr.get());
+	if (callExpr) {
+	    callExpr->initialize(retAddr);
+	} else if (!ident || ident->loadAddress() != retAddr) {
+	    expr->storeValue(retAddr);
+	}
+	gen::returnInstruction(nullptr);
+    }
+}
+
+void
+AstReturn::codegenTailCall()
+{
+    auto callExpr = dynamic_cast<const CallExpr *>(expr.get());
+    assert(callExpr);
+    // no implicit conversion of the result, it is returned unchanged
+    auto calleeRetType = callExpr->type;
+    if (!Type::equals(calleeRetType->getConstRemoved(),
+                      retType->getConstRemoved())) {
+	error::location(expr->loc);
+	error::out() << error::setColor(error::BOLD) << expr->loc << ": "
+	             << error::setColor(error::BOLD_RED)
+	             << "error: " << error::setColor(error::BOLD)
+	             << "tail call returns '" << calleeRetType
+	             << "' but the function returns '" << retType << "'\n"
+	             << error::setColor(error::NORMAL);
+	error::fatal();
+	return;
+    }
+    if (auto mismatch = gen::tailCallMismatch(callExpr->fn->type)) {
+	error::location(expr->loc);
+	error::out() << error::setColor(error::BOLD) << expr->loc << ": "
+	             << error::setColor(error::BOLD_RED)
+	             << "error: " << error::setColor(error::BOLD)
+	             << "tail call not possible: " << mismatch << "\n"
+	             << error::setColor(error::NORMAL);
+	error::fatal();
+	return;
     }
+    callExpr->tailCall();
 }
 
 /*
@@ -869,16 +1071,39 @@ AstGoto::AstGoto(lexer::Loc loc, UStr labelName)
 {
 }
 
+AstGoto::AstGoto(lexer::Loc loc, ExprPtr &&expr)
+    : loc{loc}, expr{std::move(expr)}
+{
+}
+
 void
 AstGoto::print(int indent) const
 {
+    if (expr) {
+	error::out(indent) << "goto *" << expr << ";";
+	return;
+    }
     error::out(indent) << "goto " << labelName.c_str() << ";";
 }
 
 void
 AstGoto::codegen()
 {
-    if (!label) {
+    setDebugLocation(loc);
+    if (expr) {
+	if (!expr->type->isPointer()) {
+	    error::location(expr->loc);
+	    error::out() << error::setColor(error::BOLD) << expr->loc << ": "
+	                 << error::setColor(error::BOLD_RED)
+	                 << "error: " << error::setColor(error::BOLD)
+	                 << "computed goto requires a label address, i.e. an "
+	                 << "expression of pointer type\n"
+	                 << error::setColor(error::NORMAL);
+	    error::fatal();
+	    return;
+	}
+	gen::indirectJumpInstruction(expr->loadValue());
+    } else if (!label) {
 	error::location(loc);
 	error::out() << error::setColor(error::BOLD) << loc << ": "
 	             << error::setColor(error::BOLD_RED)
@@ -896,8 +1121,10 @@ AstGoto::codegen()
  * AstLabel
  */
 AstLabel::AstLabel(lexer::Loc loc, UStr labelName)
-    : loc{loc}, labelName{labelName}, label{gen::getLabel(labelName.c_str())}
+    : loc{loc}, labelName{labelName}
 {
+    std::lock_guard lock{gen::llvmContextMutex};
+    label = gen::getLabel(labelName.c_str());
 }
 
 void
@@ -910,6 +1137,7 @@ void
 AstLabel::codegen()
 {
     gen::defineLabel(label);
+    setDebugLocation(loc);
 }
 
 /*
@@ -936,6 +1164,7 @@ AstBreak::codegen()
 	error::fatal();
 	return;
     }
+    setDebugLocation(loc);
     gen::jumpInstruction(label);
 }
 
@@ -963,6 +1192,7 @@ AstContinue::codegen()
 	error::fatal();
 	return;
     }
+    setDebugLocation(loc);
     gen::jumpInstruction(label);
 }
 
@@ -992,7 +1222,8 @@ AstExpr::codegen()
 	             << ": warning: expression statement not reachabel\n";
 	return;
     }
-    expr->loadValue();
+    setDebugLocation(expr->loc);
+    gen::discard(expr->loadValue());
 }
 
 /*
@@ -1062,6 +1293,7 @@ AstIf::codegen()
 
     bool endLabelUsed = false;
 
+    setDebugLocation(loc);
     cond->condition(thenLabel, elseLabel);
     gen::defineLabel(thenLabel);
     thenBody->codegen();
@@ -1101,8 +1333,8 @@ AstSwitch::AstSwitch(ExprPtr &&expr) : hasDefault{false}, expr{std::move(expr)}
 {
 }
 
-void
-AstSwitch::appendCase(ExprPtr &&caseExpr_)
+ExprPtr
+AstSwitch::caseValue(ExprPtr &&caseExpr_) const
 {
     if (!caseExpr_ || !caseExpr_->isConst() || !caseExpr_->type->isInteger()) {
 	error::location(caseExpr_->loc);
@@ -1114,9 +1346,40 @@ AstSwitch::appendCase(ExprPtr &&caseExpr_)
 	             << error::setColor(error::NORMAL);
 	error::fatal();
     }
-    caseExpr_ = ImplicitCast::create(std::move(caseExpr_), expr->type);
+    return ImplicitCast::create(std::move(caseExpr_), expr->type);
+}
+
+// Maps case values to unsigned integers such that the order is preserved
+static std::uint64_t
+caseKey(const Expr *caseExpr)
+{
+    if (caseExpr->type->isSignedInteger()) {
+	return std::uint64_t(caseExpr->getSignedIntValue()) ^
+	       (std::uint64_t{1} << 63);
+    }
+    return caseExpr->getUnsignedIntValue();
+}
+
+void
+AstSwitch::appendCase(ExprPtr &&caseExpr_, ExprPtr &&lastExpr)
+{
+    caseExpr_ = caseValue(std::move(caseExpr_));
+    if (lastExpr) {
+	lastExpr = caseValue(std::move(lastExpr));
+	if (caseKey(caseExpr_.get()) > caseKey(lastExpr.get())) {
+	    error::location(lastExpr->loc);
+	    error::out() << error::setColor(error::BOLD) << lastExpr->loc
+	                 << ": " << error::setColor(error::BOLD_RED)
+	                 << "error: " << error::setColor(error::BOLD)
+	                 << "empty case range '" << caseExpr_ << " ... "
+	                 << lastExpr << "'\n"
+	                 << error::setColor(error::NORMAL);
+	    error::fatal();
+	}
+    }
     casePos.push_back(body.size());
     caseExpr.push_back(std::move(caseExpr_));
+    caseLastExpr.push_back(std::move(lastExpr));
 }
 
 bool
@@ -1155,8 +1418,19 @@ AstSwitch::complete()
 	    valToEnum[type->constValue()[i]] = type->constName()[i];
 	    valUsed[type->constValue()[i]] = false;
 	}
-	for (const auto &c : caseExpr) {
-	    valUsed[c->getSignedIntValue()] = true;
+	for (std::size_t i = 0; i < caseExpr.size(); ++i) {
+	    if (!caseLastExpr[i]) {
+		valUsed[caseExpr[i]->getSignedIntValue()] = true;
+		continue;
+	    }
+	    auto first = caseKey(caseExpr[i].get());
+	    auto last = caseKey(caseLastExpr[i].get());
+	    for (auto &[val, used] : valUsed) {
+		auto key = type->isSignedInteger()
+		               ? val ^ (std::uint64_t{1} << 63)
+		               : val;
+		used = used || (key >= first && key <= last);
+	    }
 	}
 
 	std::size_t notHandled = 0;
@@ -1198,8 +1472,12 @@ AstSwitch::print(int indent) const
 	    error::out(indent + 4) << "// never reached\n";
 	}
 	while (casePosIndex < casePos.size() && i == casePos[casePosIndex]) {
-	    error::out(indent + 4)
-	        << "case " << caseExpr[casePosIndex++] << ":\n";
+	    error::out(indent + 4) << "case " << caseExpr[casePosIndex];
+	    if (caseLastExpr[casePosIndex]) {
+		error::out() << " ... " << caseLastExpr[casePosIndex];
+	    }
+	    error::out() << ":\n";
+	    ++casePosIndex;
 	}
 	if (hasDefault && i == defaultPos) {
 	    error::out(indent + 4) << "default:\n";
@@ -1210,6 +1488,49 @@ AstSwitch::print(int indent) const
     error::out(indent) << "}";
 }
 
+// Case values and ranges are kept as disjoint intervals ordered by their
+// first value. Hence a new case can only overlap with its neighbours.
+void
+AstSwitch::checkCaseOverlap() const
+{
+    // first value -> (last value, case index)
+    std::map<std::uint64_t, std::pair<std::uint64_t, std::size_t>> interval;
+
+    for (std::size_t i = 0; i < caseExpr.size(); ++i) {
+	auto first = caseKey(caseExpr[i].get());
+	auto last = caseLastExpr[i] ? caseKey(caseLastExpr[i].get()) : first;
+
+	auto next = interval.upper_bound(first);
+	auto prev = next != interval.begin() ? std::prev(next) : interval.end();
+	auto overlap = interval.end();
+	if (prev != interval.end() && prev->second.first >= first) {
+	    overlap = prev;
+	} else if (next != interval.end() && next->first <= last) {
+	    overlap = next;
+	}
+	if (overlap == interval.end()) {
+	    interval[first] = {last, i};
+	    continue;
+	}
+	auto other = overlap->second.second;
+	const auto &e = caseExpr[i];
+	if (!caseLastExpr[i] && !caseLastExpr[other]) {
+	    error::out() << e->loc << ": duplicate case value '" << e << "'\n";
+	} else {
+	    error::out() << e->loc << ": case '" << e;
+	    if (caseLastExpr[i]) {
+		error::out() << " ... " << caseLastExpr[i];
+	    }
+	    error::out() << "' overlaps with case '" << caseExpr[other];
+	    if (caseLastExpr[other]) {
+		error::out() << " ... " << caseLastExpr[other];
+	    }
+	    error::out() << "' at " << caseExpr[other]->loc << "\n";
+	}
+	error::fatal();
+    }
+}
+
 void
 AstSwitch::codegen()
 {
@@ -1217,24 +1538,36 @@ AstSwitch::codegen()
     auto breakLabel = gen::getLabel("break");
     body.apply(createSetBreakLabel(breakLabel));
 
-    std::vector<std::pair<gen::ConstantInt, gen::Label>> caseLabel;
-    std::set<std::uint64_t> usedCaseVal;
+    checkCaseOverlap();
 
-    for (const auto &e : caseExpr) {
-	caseLabel.push_back({e->getConstantInt(), gen::getLabel("case")});
-	auto val = e->getUnsignedIntValue();
-	if (usedCaseVal.contains(val)) {
-	    error::out() << e->loc << ": duplicate case value '" << e << "'\n";
-	    error::fatal();
+    std::vector<gen::Label> label;
+    std::vector<gen::CaseLabel> caseLabel;
+    std::vector<gen::CaseRange> caseRange;
+    for (std::size_t i = 0; i < caseExpr.size(); ++i) {
+	label.push_back(gen::getLabel("case"));
+	if (caseLastExpr[i]) {
+	    caseRange.push_back({caseExpr[i]->getConstantInt(),
+	                         caseLastExpr[i]->getConstantInt(), label[i]});
+	} else {
+	    caseLabel.push_back({caseExpr[i]->getConstantInt(), label[i]});
 	}
-	usedCaseVal.insert(val);
     }
 
-    gen::jumpInstruction(expr->loadValue(), defaultLabel, caseLabel);
+    setDebugLocation(expr->loc);
+    auto origin = gen::jumpInstruction(expr->loadValue(), defaultLabel,
+                                       caseLabel, caseRange);
+    if (gen::opt::reportSwitch) {
+	error::out() << error::setColor(error::BOLD) << expr->loc << ": "
+	             << error::setColor(error::BOLD_BLUE)
+	             << "remark: " << error::setColor(error::BOLD)
+	             << "switch lowered to " << gen::switchLowering(origin)
+	             << "\n"
+	             << error::setColor(error::NORMAL);
+    }
 
     for (std::size_t i = 0, casePosIndex = 0; i < body.size(); ++i) {
 	while (casePosIndex < casePos.size() && i == casePos[casePosIndex]) {
-	    gen::defineLabel(caseLabel[casePosIndex++].second);
+	    gen::defineLabel(label[casePosIndex++]);
 	}
 	if (hasDefault && i == defaultPos) {
 	    gen::defineLabel(defaultLabel);
@@ -1253,6 +1586,35 @@ AstSwitch::apply(std::function<bool(Ast *)> op)
     body.apply(op);
 }
 
+/*
+ * AstLoop
+ */
+void
+AstLoop::printLoopHint(int indent) const
+{
+    if (loopHint.noUnroll) {
+	error::out(indent) << "@nounroll\n";
+    } else if (loopHint.unrollFull) {
+	error::out(indent) << "@unroll\n";
+    } else if (loopHint.unrollCount) {
+	error::out(indent) << "@unroll(" << loopHint.unrollCount << ")\n";
+    }
+    if (loopHint.vectorizeWidth) {
+	error::out(indent) << "@vectorize(" << loopHint.vectorizeWidth
+	                   << ")\n";
+    }
+    if (loopHint.interleaveCount) {
+	error::out(indent) << "@interleave(" << loopHint.interleaveCount
+	                   << ")\n";
+    }
+}
+
+void
+AstLoop::setLoopMetadata(gen::Label header) const
+{
+    gen::setLoopMetadata(header, loopHint);
+}
+
 /*
  * AstWhile
  */
@@ -1264,6 +1626,7 @@ AstWhile::AstWhile(ExprPtr &&cond, AstPtr &&body)
 void
 AstWhile::print(int indent) const
 {
+    printLoopHint(indent);
     error::out(indent) << "while (" << cond << ") {\n";
     body->print(indent + 4);
     error::out(indent) << "}";
@@ -1280,11 +1643,13 @@ AstWhile::codegen()
     body->apply(createSetContinueLabel(condLabel));
 
     gen::defineLabel(condLabel);
+    setDebugLocation(cond->loc);
     cond->condition(loopLabel, endLabel);
 
     gen::defineLabel(loopLabel);
     body->codegen();
     gen::jumpInstruction(condLabel);
+    setLoopMetadata(condLabel);
 
     gen::defineLabel(endLabel);
 }
@@ -1308,6 +1673,7 @@ AstDoWhile::AstDoWhile(ExprPtr &&cond, AstPtr &&body)
 void
 AstDoWhile::print(int indent) const
 {
+    printLoopHint(indent);
     error::out(indent) << "do {\n";
     body->print(indent + 4);
     error::out(indent) << "} while (" << cond << ");";
@@ -1327,7 +1693,9 @@ AstDoWhile::codegen()
     body->codegen();
 
     gen::defineLabel(condLabel);
+    setDebugLocation(cond->loc);
     cond->condition(loopLabel, endLabel);
+    setLoopMetadata(loopLabel);
 
     gen::defineLabel(endLabel);
 }
@@ -1363,6 +1731,7 @@ AstFor::appendBody(AstPtr &&body_)
 void
 AstFor::print(int indent) const
 {
+    printLoopHint(indent);
     error::out(indent) << "for (";
     if (initAst) {
 	initAst->print(0);
@@ -1395,20 +1764,24 @@ AstFor::codegen()
     if (initAst) {
 	initAst->codegen();
     } else if (initExpr) {
+	setDebugLocation(initExpr->loc);
 	initExpr->loadValue();
     }
 
     gen::defineLabel(condLabel);
     if (cond) {
+	setDebugLocation(cond->loc);
 	cond->condition(loopLabel, endLabel);
     }
 
     gen::defineLabel(loopLabel);
     body->codegen();
     if (update) {
+	setDebugLocation(update->loc);
 	update->loadValue();
     }
     gen::jumpInstruction(condLabel);
+    setLoopMetadata(condLabel);
 
     gen::defineLabel(endLabel);
 }
@@ -1593,7 +1966,8 @@ AstEnumDecl::codegen()
 /*
  * AstStructDecl
  */
-AstStructDecl::AstStructDecl(lexer::Token name) : structTypeName{name}
+AstStructDecl::AstStructDecl(lexer::Token name)
+    : structTypeName{name}, packed{false}, alignment{0}
 {
     if (auto found = Symtab::type(name.val, Symtab::CurrentScope)) {
 	// if <name> is already a type declaration it has to be an incomplete
@@ -1652,8 +2026,11 @@ AstStructDecl::add(std::vector<lexer::Token> &&memberName,
 }
 
 void
-AstStructDecl::complete()
+AstStructDecl::complete(bool packed, std::size_t alignment)
 {
+    this->packed = packed;
+    this->alignment = alignment;
+
     std::unordered_map<UStr, lexer::Loc> memberMap;
     std::vector<UStr> memberName;
     std::vector<const Type *> memberType;
@@ -1704,7 +2081,7 @@ AstStructDecl::complete()
     }
     structType->complete(std::move(memberName),
                          std::vector<std::size_t>{memberIndex},
-                         std::move(memberType));
+                         std::move(memberType), packed, alignment);
 }
 
 const Type *
@@ -1719,7 +2096,14 @@ AstStructDecl::print(int indent) const
     if (!memberDecl.size()) {
 	error::out(indent) << "struct " << structTypeName.val << ";";
     } else {
-	error::out(indent) << "struct " << structTypeName.val << "\n";
+	error::out(indent) << "struct " << structTypeName.val;
+	if (packed) {
+	    error::out() << " packed";
+	}
+	if (alignment) {
+	    error::out() << " alignas(" << alignment << ")";
+	}
+	error::out() << "\n";
 	error::out(indent) << "{\n";
 
 	std::size_t pos = 0;
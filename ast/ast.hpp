@@ -3,11 +3,14 @@
 
 #include <functional>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
 #include "expr/enumconstant.hpp"
 #include "expr/expr.hpp"
+#include "gen/loop.hpp"
 #include "lexer/loc.hpp"
 #include "lexer/token.hpp"
 #include "symtab/symtab.hpp"
@@ -74,6 +77,7 @@ class AstFuncDef : public Ast
 	std::vector<lexer::Token> fnParamName;
 	std::vector<const char *> fnParamId;
 	AstPtr body;
+	std::unordered_map<UStr, gen::Label> label;
 
     public:
 	AstFuncDef(lexer::Token fnName, const Type *fnType);
@@ -81,6 +85,8 @@ class AstFuncDef : public Ast
 	const lexer::Token fnName;
 	const Type *const fnType;
 	UStr fnId;
+	// CPU feature lists of '@target_clones', empty if not multiversioned
+	std::vector<std::string> targetClones;
 
 	void appendParamName(std::vector<lexer::Token> &&fnParamName);
 	void appendBody(AstPtr &&body);
@@ -114,6 +120,7 @@ class AstVar : public Ast
 	std::vector<UStr> varId;
 	std::vector<const Type *> varType;
 	const Type *varDeclType;
+	std::size_t alignment;
 
     public:
 	AstVar(lexer::Token varName, lexer::Loc varTypeLoc, const Type *varType,
@@ -131,9 +138,13 @@ class AstVar : public Ast
 	const UStr getId(std::size_t index) const;
 	const Type *getType(std::size_t index) const;
 
+	void setAlignment(std::size_t alignment);
+	std::size_t getAlignment() const;
+
 	void setExternalLinkage();
 	void setInternalLinkage();
 	void setLinkage();
+	void setThreadLocal(bool threadLocal);
 
 	void print(int indent) const override;
 };
@@ -145,9 +156,10 @@ using AstVarPtr = std::unique_ptr<AstVar>;
 class AstExternVar : public Ast
 {
     public:
-	AstExternVar(AstListPtr &&declList);
+	AstExternVar(AstListPtr &&declList, bool threadLocal = false);
 
 	const AstListPtr declList;
+	const bool threadLocal;
 
 	void print(int indent) const override;
 	void codegen() override;
@@ -158,9 +170,10 @@ class AstExternVar : public Ast
 class AstGlobalVar : public Ast
 {
     public:
-	AstGlobalVar(AstListPtr &&declList);
+	AstGlobalVar(AstListPtr &&declList, bool threadLocal = false);
 
 	const AstListPtr declList;
+	const bool threadLocal;
 
 	void print(int indent) const override;
 	void codegen() override;
@@ -171,9 +184,10 @@ class AstGlobalVar : public Ast
 class AstStaticVar : public Ast
 {
     public:
-	AstStaticVar(AstListPtr &&declList);
+	AstStaticVar(AstListPtr &&declList, bool threadLocal = false);
 
 	const AstListPtr declList;
+	const bool threadLocal;
 
 	void print(int indent) const override;
 	void codegen() override;
@@ -197,14 +211,19 @@ class AstLocalVar : public Ast
 class AstReturn : public Ast
 {
     public:
-	AstReturn(lexer::Loc loc, ExprPtr &&expr);
+	AstReturn(lexer::Loc loc, ExprPtr &&expr, bool tailCall = false);
 
 	lexer::Loc loc;
 	ExprPtr expr;
+	// 'return tail f(...)' guarantees that the call is a tail call
+	bool tailCall;
 	const Type *retType = nullptr;
 
 	void print(int indent) const override;
 	void codegen() override;
+
+    private:
+	void codegenTailCall();
 };
 
 //------------------------------------------------------------------------------
@@ -241,10 +260,13 @@ class AstGoto : public Ast
 {
     public:
 	AstGoto(lexer::Loc loc, UStr labelName);
+	// computed goto, i.e. 'goto *expr'
+	AstGoto(lexer::Loc loc, ExprPtr &&expr);
 
 	const lexer::Loc loc;
 	UStr labelName;
 	gen::Label label = nullptr;
+	ExprPtr expr;
 
 	void print(int indent) const override;
 	void codegen() override;
@@ -306,15 +328,20 @@ class AstSwitch : public Ast
 	AstList body;
 	std::vector<std::size_t> casePos;
 	std::vector<ExprPtr> caseExpr;
+	// last value of a case range, nullptr for a single value
+	std::vector<ExprPtr> caseLastExpr;
 	std::size_t defaultPos;
 	bool hasDefault;
 
+	ExprPtr caseValue(ExprPtr &&caseExpr) const;
+	void checkCaseOverlap() const;
+
     public:
 	AstSwitch(ExprPtr &&expr);
 
 	const ExprPtr expr;
 
-	void appendCase(ExprPtr &&expr);
+	void appendCase(ExprPtr &&expr, ExprPtr &&lastExpr = nullptr);
 	bool appendDefault();
 	void append(AstPtr &&stmt);
 	void complete();
@@ -326,7 +353,19 @@ class AstSwitch : public Ast
 
 //------------------------------------------------------------------------------
 
-class AstWhile : public Ast
+class AstLoop : public Ast
+{
+    public:
+	gen::LoopHint loopHint;
+
+    protected:
+	void printLoopHint(int indent) const;
+	void setLoopMetadata(gen::Label header) const;
+};
+
+//------------------------------------------------------------------------------
+
+class AstWhile : public AstLoop
 {
     public:
 	AstWhile(ExprPtr &&cond, AstPtr &&body);
@@ -341,7 +380,7 @@ class AstWhile : public Ast
 
 //------------------------------------------------------------------------------
 
-class AstDoWhile : public Ast
+class AstDoWhile : public AstLoop
 {
     public:
 	AstDoWhile(ExprPtr &&cond, AstPtr &&body);
@@ -356,7 +395,7 @@ class AstDoWhile : public Ast
 
 //------------------------------------------------------------------------------
 
-class AstFor : public Ast
+class AstFor : public AstLoop
 {
     private:
 	AstPtr body;
@@ -426,6 +465,8 @@ class AstStructDecl : public Ast
 	using MemberDecl = std::pair<std::vector<lexer::Token>, AstOrType>;
 	std::vector<MemberDecl> memberDecl;
 	std::vector<std::size_t> memberIndex;
+	bool packed;
+	std::size_t alignment;
 
     public:
 	AstStructDecl(lexer::Token structTypeName);
@@ -435,7 +476,7 @@ class AstStructDecl : public Ast
 	         const Type *memberType);
 	void add(std::vector<lexer::Token> &&memberName,
 	         std::vector<std::size_t> &&memberIndex, AstPtr &&memberType);
-	void complete();
+	void complete(bool packed = false, std::size_t alignment = 0);
 	const Type *getStructType() const;
 
 	void print(int indent) const override;
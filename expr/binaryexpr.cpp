@@ -1,8 +1,10 @@
 #include <cassert>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 
 #include "gen/constant.hpp"
+#include "gen/gentype.hpp"
 #include "gen/instruction.hpp"
 #include "gen/label.hpp"
 #include "gen/variable.hpp"
@@ -10,6 +12,7 @@
 #include "type/integertype.hpp"
 
 #include "binaryexpr.hpp"
+#include "identifier.hpp"
 #include "promotion.hpp"
 
 static const char *kindStr(abc::BinaryExpr::Kind kind);
@@ -75,6 +78,8 @@ BinaryExpr::isConst() const
     // special case
     if (kind == SUB && left->type->isPointer() && right->type->isPointer()) {
 	auto refType = left->type->refType();
+	// also called by the parser, see ConditionalExpr::isConst()
+	std::lock_guard lock{gen::llvmContextMutex};
 	auto diff = gen::pointerConstantDifference(refType, left->loadValue(),
 	                                           right->loadValue());
 	return diff.has_value();
@@ -106,6 +111,42 @@ BinaryExpr::isConst() const
     }
 }
 
+std::optional<std::size_t>
+BinaryExpr::speculationCost() const
+{
+    if (isConst()) {
+	return 0;
+    }
+    switch (kind) {
+    case ADD:
+    case SUB:
+    case MUL:
+    case BITWISE_AND:
+    case BITWISE_OR:
+    case BITWISE_XOR:
+    case BITWISE_LEFT_SHIFT:
+    case BITWISE_RIGHT_SHIFT:
+    case LESS:
+    case LESS_EQUAL:
+    case GREATER:
+    case GREATER_EQUAL:
+    case NOT_EQUAL:
+    case EQUAL:
+    case LOGICAL_AND:
+    case LOGICAL_OR:
+	break;
+    default:
+	// assignments have side effects, division and indexing can trap
+	return std::nullopt;
+    }
+    auto leftCost = left->speculationCost();
+    auto rightCost = right->speculationCost();
+    if (!leftCost || !rightCost) {
+	return std::nullopt;
+    }
+    return leftCost.value() + rightCost.value() + 1;
+}
+
 // for code generation
 gen::Constant
 BinaryExpr::loadConstant() const
@@ -241,6 +282,29 @@ BinaryExpr::handleArithmetricOperation(Kind kind) const
     }
 }
 
+// The right operand of an assignment is evaluated first. For a large aggregate
+// assigned to a variable it can be constructed in place, because computing
+// the address of the variable has no side effects. Otherwise it is
+// constructed in a temporary that is copied.
+static gen::Value
+assignLargeAggregate(const ExprPtr &left, const ExprPtr &right)
+{
+    if (dynamic_cast<const Identifier *>(left.get())) {
+	auto addr = left->loadAddress();
+	right->storeValue(addr);
+	return gen::fetch(addr, left->type);
+    }
+    static std::size_t idCount;
+    std::stringstream ss;
+    ss << ".assign" << idCount++;
+    auto tmpId = UStr::create(ss.str()).c_str();
+    auto tmpAddr = gen::localVariableDefinition(tmpId, right->type);
+    right->storeValue(tmpAddr);
+    auto addr = left->loadAddress();
+    gen::copy(addr, tmpAddr, left->type);
+    return gen::fetch(addr, left->type);
+}
+
 gen::Value
 BinaryExpr::loadValue() const
 {
@@ -249,8 +313,14 @@ BinaryExpr::loadValue() const
     }
     assert(type);
     switch (kind) {
-    case ASSIGN:
-	return gen::store(right->loadValue(), left->loadAddress());
+    case ASSIGN: {
+	if (gen::isLargeAggregate(type)) {
+	    return assignLargeAggregate(left, right);
+	}
+	// sequenced explicitly, the order of arguments is unspecified
+	auto val = right->loadValue();
+	return gen::store(val, left->loadAddress());
+    }
     case ADD_ASSIGN:
 	return gen::store(handleArithmetricOperation(ADD), left->loadAddress());
     case SUB_ASSIGN:
@@ -297,6 +367,16 @@ BinaryExpr::loadValue() const
 	                        left->loadValue(), right->loadValue());
     case LOGICAL_AND:
     case LOGICAL_OR: {
+	if (right->isCheap()) {
+	    // both operands are bool, no need for short-circuit evaluation.
+	    // A select instead of 'and'/'or' does not propagate poison from
+	    // the right operand if the left one decides, e.g. an oversized
+	    // shift in 'n < 32 && (x >> n) != 0'.
+	    auto l = left->loadValue();
+	    auto r = right->loadValue();
+	    return kind == LOGICAL_AND ? gen::select(l, r, gen::getFalse())
+	                               : gen::select(l, gen::getTrue(), r);
+	}
 	auto trueLabel = gen::getLabel("true");
 	auto falseLabel = gen::getLabel("false");
 	auto phiLabel = gen::getLabel("true");
@@ -369,6 +449,10 @@ BinaryExpr::condition(gen::Label trueLabel, gen::Label falseLabel) const
 	return;
     }
     case LOGICAL_AND: {
+	if (left->isCheap() && right->isCheap()) {
+	    gen::jumpInstruction(loadValue(), trueLabel, falseLabel);
+	    return;
+	}
 	auto chkRightLabel = gen::getLabel("chkRight");
 
 	left->condition(chkRightLabel, falseLabel);
@@ -377,6 +461,10 @@ BinaryExpr::condition(gen::Label trueLabel, gen::Label falseLabel) const
 	return;
     }
     case LOGICAL_OR: {
+	if (left->isCheap() && right->isCheap()) {
+	    gen::jumpInstruction(loadValue(), trueLabel, falseLabel);
+	    return;
+	}
 	auto chkRightLabel = gen::getLabel("chkRight");
 
 	left->condition(trueLabel, chkRightLabel);
@@ -70,6 +70,7 @@ class BinaryExpr : public Expr
 	bool isLValue() const override;
 
 	bool isConst() const override;
+	std::optional<std::size_t> speculationCost() const override;
 
 	// for code generation
 	gen::Constant loadConstant() const override;
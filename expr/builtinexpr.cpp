@@ -0,0 +1,449 @@
+#include <iomanip>
+#include <iostream>
+
+#include "gen/atomic.hpp"
+#include "gen/instruction.hpp"
+#include "gen/intrinsic.hpp"
+#include "gen/label.hpp"
+#include "gen/variable.hpp"
+#include "lexer/error.hpp"
+#include "type/integertype.hpp"
+#include "type/pointertype.hpp"
+#include "type/voidtype.hpp"
+
+#include "builtinexpr.hpp"
+#include "implicitcast.hpp"
+
+namespace abc {
+
+struct BuiltinInfo
+{
+    const char *name;
+    BuiltinExpr::Kind kind;
+    std::size_t numArgs;
+};
+
+static const BuiltinInfo builtinInfo[] = {
+    {"atomic_load", BuiltinExpr::ATOMIC_LOAD, 2},
+    {"atomic_store", BuiltinExpr::ATOMIC_STORE, 3},
+    {"atomic_exchange", BuiltinExpr::ATOMIC_EXCHANGE, 3},
+    {"atomic_fetch_add", BuiltinExpr::ATOMIC_FETCH_ADD, 3},
+    {"atomic_fetch_sub", BuiltinExpr::ATOMIC_FETCH_SUB, 3},
+    {"atomic_fetch_and", BuiltinExpr::ATOMIC_FETCH_AND, 3},
+    {"atomic_fetch_or", BuiltinExpr::ATOMIC_FETCH_OR, 3},
+    {"atomic_fetch_xor", BuiltinExpr::ATOMIC_FETCH_XOR, 3},
+    {"atomic_cas", BuiltinExpr::ATOMIC_CAS, 4},
+    {"fence", BuiltinExpr::FENCE, 1},
+    {"ctpop", BuiltinExpr::CTPOP, 1},
+    {"ctlz", BuiltinExpr::CTLZ, 1},
+    {"cttz", BuiltinExpr::CTTZ, 1},
+    {"bswap", BuiltinExpr::BSWAP, 1},
+    {"fshl", BuiltinExpr::FSHL, 3},
+    {"prefetch", BuiltinExpr::PREFETCH, 3},
+    {"assume", BuiltinExpr::ASSUME, 1},
+    {"expect", BuiltinExpr::EXPECT, 2},
+};
+
+static const BuiltinInfo *
+getBuiltinInfo(UStr name)
+{
+    for (const auto &info : builtinInfo) {
+	if (name == UStr::create(info.name)) {
+	    return &info;
+	}
+    }
+    return nullptr;
+}
+
+static void
+builtinError(lexer::Loc loc, UStr name, const std::string &msg)
+{
+    error::location(loc);
+    error::out() << error::setColor(error::BOLD) << loc << ": "
+                 << error::setColor(error::BOLD_RED)
+                 << "error: " << error::setColor(error::BOLD) << "builtin '"
+                 << name << "': " << msg << "\n"
+                 << error::setColor(error::NORMAL);
+    error::fatal();
+}
+
+static gen::AtomicOrdering
+getOrdering(UStr name, BuiltinExpr::Kind kind, const ExprPtr &expr)
+{
+    if (!expr->isConst() || !expr->type->isInteger()) {
+	builtinError(expr->loc, name,
+	             "memory order has to be a constant integer expression");
+    }
+    auto val = expr->getSignedIntValue();
+    if (val < gen::RELAXED || val > gen::SEQ_CST) {
+	builtinError(expr->loc, name, "invalid memory order");
+    }
+    auto ordering = static_cast<gen::AtomicOrdering>(val);
+
+    bool ok = true;
+    if (kind == BuiltinExpr::ATOMIC_LOAD) {
+	ok = ordering != gen::RELEASE && ordering != gen::ACQ_REL;
+    } else if (kind == BuiltinExpr::ATOMIC_STORE) {
+	ok = ordering != gen::ACQUIRE && ordering != gen::ACQ_REL;
+    }
+    if (!ok) {
+	builtinError(expr->loc, name, "memory order not allowed here");
+    }
+    return ordering;
+}
+
+BuiltinExpr::BuiltinExpr(Kind kind, UStr name, std::vector<ExprPtr> &&arg,
+                         std::optional<gen::AtomicOrdering> ordering,
+                         const Type *type, lexer::Loc loc)
+    : Expr{loc, type}, kind{kind}, name{name}, arg{std::move(arg)}
+    , ordering{ordering}
+{
+}
+
+const std::vector<UStr> &
+BuiltinExpr::nameList()
+{
+    static std::vector<UStr> list;
+    if (list.empty()) {
+	for (const auto &info : builtinInfo) {
+	    list.push_back(UStr::create(info.name));
+	}
+    }
+    return list;
+}
+
+static bool
+isAtomic(BuiltinExpr::Kind kind)
+{
+    return kind >= BuiltinExpr::ATOMIC_LOAD && kind <= BuiltinExpr::FENCE;
+}
+
+static void
+checkConstInt(UStr name, const ExprPtr &expr, std::int64_t min,
+              std::int64_t max)
+{
+    if (!expr->isConst() || !expr->type->isInteger()) {
+	builtinError(expr->loc, name,
+	             "argument has to be a constant integer expression");
+    }
+    auto val = expr->getSignedIntValue();
+    if (val < min || val > max) {
+	builtinError(expr->loc, name,
+	             "argument has to be in the range " + std::to_string(min) +
+	                 " to " + std::to_string(max));
+    }
+}
+
+// checks the arguments of a non-atomic builtin and returns the result type
+static const Type *
+checkIntrinsic(BuiltinExpr::Kind kind, UStr name, std::vector<ExprPtr> &arg)
+{
+    switch (kind) {
+    case BuiltinExpr::PREFETCH:
+	// prefetch(addr, rw, locality)
+	if (!arg[0]->type->isPointer()) {
+	    builtinError(arg[0]->loc, name, "pointer argument required");
+	}
+	checkConstInt(name, arg[1], 0, 1);
+	checkConstInt(name, arg[2], 0, 3);
+	return VoidType::create();
+    case BuiltinExpr::ASSUME:
+	if (!arg[0]->type->isScalar()) {
+	    builtinError(arg[0]->loc, name, "scalar argument required");
+	}
+	arg[0] = ImplicitCast::create(std::move(arg[0]),
+	                              IntegerType::createBool());
+	return VoidType::create();
+    default:
+	break;
+    }
+
+    // all other intrinsics operate on integers. The type of the first
+    // argument determines the type of the result.
+    auto type = arg[0]->type->getConstRemoved();
+    if (!type->isInteger() || (type->isBool() && kind != BuiltinExpr::EXPECT)) {
+	builtinError(arg[0]->loc, name, "integer argument required");
+    }
+    if (kind == BuiltinExpr::BSWAP && type->numBits() % 16) {
+	builtinError(arg[0]->loc, name,
+	             "number of bits has to be a multiple of 16");
+    }
+    if (kind == BuiltinExpr::EXPECT && !arg[1]->isConst()) {
+	builtinError(arg[1]->loc, name,
+	             "expected value has to be a constant expression");
+    }
+    for (std::size_t i = 1; i < arg.size(); ++i) {
+	arg[i] = ImplicitCast::create(std::move(arg[i]), type);
+    }
+    return type;
+}
+
+ExprPtr
+BuiltinExpr::create(UStr name, std::vector<ExprPtr> &&arg, lexer::Loc loc)
+{
+    auto info = getBuiltinInfo(name);
+    assert(info);
+
+    auto kind = info->kind;
+    if (arg.size() != info->numArgs) {
+	builtinError(loc, name,
+	             "expected " + std::to_string(info->numArgs) +
+	                 " argument(s)");
+    }
+
+    if (!isAtomic(kind)) {
+	auto type = checkIntrinsic(kind, name, arg);
+	auto p = new BuiltinExpr{kind, name, std::move(arg),
+	                         std::nullopt, type, loc};
+	return std::unique_ptr<BuiltinExpr>{p};
+    }
+
+    auto ordering = getOrdering(name, kind, arg.back());
+    if (kind == FENCE) {
+	auto type = VoidType::create();
+	auto p =
+	    new BuiltinExpr{kind, name, std::move(arg), ordering, type, loc};
+	return std::unique_ptr<BuiltinExpr>{p};
+    }
+
+    // all atomic operations take the address of the object as first argument
+    if (!arg[0]->type->isPointer()) {
+	builtinError(arg[0]->loc, name, "pointer argument required");
+    }
+    auto objType = arg[0]->type->refType();
+    auto valType = objType->getConstRemoved();
+    bool isFetchOp = kind >= ATOMIC_FETCH_ADD && kind <= ATOMIC_FETCH_XOR;
+    bool validType = (valType->isInteger() && !valType->isBool()) ||
+                     (!isFetchOp && valType->isPointer());
+    if (!validType) {
+	builtinError(arg[0]->loc, name,
+	             "no atomic operation for objects of this type");
+    }
+    if (kind != ATOMIC_LOAD && !Type::assignable(objType)) {
+	builtinError(arg[0]->loc, name, "object is readonly");
+    }
+
+    const Type *type = valType;
+    switch (kind) {
+    case ATOMIC_LOAD:
+	break;
+    case ATOMIC_STORE:
+	arg[1] = ImplicitCast::create(std::move(arg[1]), valType);
+	type = VoidType::create();
+	break;
+    case ATOMIC_CAS:
+	// expected value is passed by address and updated on failure
+	arg[1] = ImplicitCast::create(std::move(arg[1]),
+	                              PointerType::create(valType));
+	arg[2] = ImplicitCast::create(std::move(arg[2]), valType);
+	type = IntegerType::createBool();
+	break;
+    default:
+	arg[1] = ImplicitCast::create(std::move(arg[1]), valType);
+	break;
+    }
+
+    auto p = new BuiltinExpr{kind, name, std::move(arg), ordering, type, loc};
+    return std::unique_ptr<BuiltinExpr>{p};
+}
+
+bool
+BuiltinExpr::hasAddress() const
+{
+    return false;
+}
+
+bool
+BuiltinExpr::isLValue() const
+{
+    return false;
+}
+
+bool
+BuiltinExpr::isConst() const
+{
+    switch (kind) {
+    case CTPOP:
+    case CTLZ:
+    case CTTZ:
+    case BSWAP:
+    case FSHL:
+    case EXPECT:
+	for (const auto &a : arg) {
+	    if (!a->isConst()) {
+		return false;
+	    }
+	}
+	return true;
+    default:
+	return false;
+    }
+}
+
+static gen::IntrinsicOp
+getIntrinsicOp(BuiltinExpr::Kind kind)
+{
+    switch (kind) {
+    case BuiltinExpr::CTPOP:
+	return gen::CTPOP;
+    case BuiltinExpr::CTLZ:
+	return gen::CTLZ;
+    case BuiltinExpr::CTTZ:
+	return gen::CTTZ;
+    case BuiltinExpr::BSWAP:
+	return gen::BSWAP;
+    case BuiltinExpr::FSHL:
+	return gen::FSHL;
+    default:
+	assert(0);
+	return gen::CTPOP;
+    }
+}
+
+// for code generation
+gen::Constant
+BuiltinExpr::loadConstant() const
+{
+    assert(isConst());
+    if (kind == EXPECT) {
+	// the hint is useless for a constant
+	return arg[0]->loadConstant();
+    }
+    std::vector<gen::Constant> argConstant;
+    for (const auto &a : arg) {
+	argConstant.push_back(a->loadConstant());
+    }
+    return gen::intrinsic(getIntrinsicOp(kind), argConstant);
+}
+
+static gen::AtomicRmwOp
+getRmwOp(BuiltinExpr::Kind kind)
+{
+    switch (kind) {
+    case BuiltinExpr::ATOMIC_EXCHANGE:
+	return gen::ATOMIC_XCHG;
+    case BuiltinExpr::ATOMIC_FETCH_ADD:
+	return gen::ATOMIC_ADD;
+    case BuiltinExpr::ATOMIC_FETCH_SUB:
+	return gen::ATOMIC_SUB;
+    case BuiltinExpr::ATOMIC_FETCH_AND:
+	return gen::ATOMIC_AND;
+    case BuiltinExpr::ATOMIC_FETCH_OR:
+	return gen::ATOMIC_OR;
+    case BuiltinExpr::ATOMIC_FETCH_XOR:
+	return gen::ATOMIC_XOR;
+    default:
+	assert(0);
+	return gen::ATOMIC_XCHG;
+    }
+}
+
+gen::Value
+BuiltinExpr::loadValue() const
+{
+    switch (kind) {
+    case ATOMIC_LOAD:
+	return gen::atomicLoad(arg[0]->loadValue(), type, *ordering);
+    case ATOMIC_STORE: {
+	auto addr = arg[0]->loadValue();
+	gen::atomicStore(arg[1]->loadValue(), addr, *ordering);
+	return nullptr;
+    }
+    case ATOMIC_EXCHANGE:
+    case ATOMIC_FETCH_ADD:
+    case ATOMIC_FETCH_SUB:
+    case ATOMIC_FETCH_AND:
+    case ATOMIC_FETCH_OR:
+    case ATOMIC_FETCH_XOR: {
+	auto addr = arg[0]->loadValue();
+	return gen::atomicRmw(getRmwOp(kind), addr, arg[1]->loadValue(),
+	                      *ordering);
+    }
+    case ATOMIC_CAS: {
+	auto addr = arg[0]->loadValue();
+	auto expectedAddr = arg[1]->loadValue();
+	auto desired = arg[2]->loadValue();
+	auto expected = gen::fetch(expectedAddr, arg[2]->type);
+	auto [old, success] =
+	    gen::atomicCmpXchg(addr, expected, desired, *ordering);
+
+	// on failure the current value gets stored in *expected
+	auto failLabel = gen::getLabel("cas.fail");
+	auto doneLabel = gen::getLabel("cas.done");
+	gen::jumpInstruction(success, doneLabel, failLabel);
+	gen::defineLabel(failLabel);
+	gen::store(old, expectedAddr);
+	gen::defineLabel(doneLabel);
+	return success;
+    }
+    case FENCE:
+	gen::fence(*ordering);
+	return nullptr;
+    case CTPOP:
+    case CTLZ:
+    case CTTZ:
+    case BSWAP:
+    case FSHL: {
+	if (isConst()) {
+	    return loadConstant();
+	}
+	std::vector<gen::Value> argValue;
+	for (const auto &a : arg) {
+	    argValue.push_back(a->loadValue());
+	}
+	return gen::intrinsic(getIntrinsicOp(kind), argValue);
+    }
+    case PREFETCH: {
+	auto write = arg[1]->getUnsignedIntValue() != 0;
+	auto locality = arg[2]->getUnsignedIntValue();
+	gen::prefetch(arg[0]->loadValue(), write, locality);
+	return nullptr;
+    }
+    case ASSUME:
+	gen::assume(arg[0]->loadValue());
+	return nullptr;
+    case EXPECT:
+	if (isConst()) {
+	    return loadConstant();
+	}
+	return gen::expect(arg[0]->loadValue(), arg[1]->loadConstant());
+    default:
+	assert(0);
+	return nullptr;
+    }
+}
+
+gen::Value
+BuiltinExpr::loadAddress() const
+{
+    assert(0 && "BuiltinExpr has no address");
+    return nullptr;
+}
+
+// for debugging and educational purposes
+void
+BuiltinExpr::print(int indent) const
+{
+    if (indent) {
+	std::cerr << std::setfill(' ') << std::setw(indent) << ' ';
+    }
+    std::cerr << "builtin " << name << " [ " << type << " ] " << std::endl;
+    for (const auto &a : arg) {
+	a->print(indent + 4);
+    }
+}
+
+void
+BuiltinExpr::printFlat(std::ostream &out, int prec) const
+{
+    out << name << "(";
+    for (std::size_t i = 0; i < arg.size(); ++i) {
+	out << arg[i];
+	if (i + 1 < arg.size()) {
+	    out << ", ";
+	}
+    }
+    out << ")";
+}
+
+} // namespace abc
@@ -0,0 +1,73 @@
+#ifndef EXPR_BUILTINEXPR_HPP
+#define EXPR_BUILTINEXPR_HPP
+
+#include <optional>
+#include <vector>
+
+#include "gen/atomic.hpp"
+
+#include "expr.hpp"
+
+namespace abc {
+
+class BuiltinExpr : public Expr
+{
+    public:
+	enum Kind
+	{
+	    ATOMIC_LOAD,
+	    ATOMIC_STORE,
+	    ATOMIC_EXCHANGE,
+	    ATOMIC_FETCH_ADD,
+	    ATOMIC_FETCH_SUB,
+	    ATOMIC_FETCH_AND,
+	    ATOMIC_FETCH_OR,
+	    ATOMIC_FETCH_XOR,
+	    ATOMIC_CAS,
+	    FENCE,
+	    CTPOP,
+	    CTLZ,
+	    CTTZ,
+	    BSWAP,
+	    FSHL,
+	    PREFETCH,
+	    ASSUME,
+	    EXPECT,
+	};
+
+    protected:
+	BuiltinExpr(Kind kind, UStr name, std::vector<ExprPtr> &&arg,
+	            std::optional<gen::AtomicOrdering> ordering,
+	            const Type *type,
+	            lexer::Loc loc);
+
+    public:
+	static const std::vector<UStr> &nameList();
+	static ExprPtr create(UStr name, std::vector<ExprPtr> &&arg,
+	                      lexer::Loc loc = lexer::Loc{});
+
+	const Kind kind;
+	const UStr name;
+	std::vector<ExprPtr> arg;
+	// only for atomic operations and fences
+	const std::optional<gen::AtomicOrdering> ordering;
+
+	bool hasAddress() const override;
+	bool isLValue() const override;
+	bool isConst() const override;
+
+	// for code generation
+	gen::Constant loadConstant() const override;
+	gen::Value loadValue() const override;
+	gen::Value loadAddress() const override;
+
+	// for debugging and educational purposes
+	void print(int indent) const override;
+
+	// for printing error messages
+	virtual void printFlat(std::ostream &out, int prec) const override;
+};
+
+} // namespace abc
+
+#endif // EXPR_BUILTINEXPR_HPP
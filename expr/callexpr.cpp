@@ -1,6 +1,7 @@
 #include <iomanip>
 #include <iostream>
 
+#include "gen/debuginfo.hpp"
 #include "gen/function.hpp"
 #include "gen/variable.hpp"
 
@@ -22,8 +23,7 @@ CallExpr::CallExpr(ExprPtr &&fn, std::vector<ExprPtr> &&arg, const Type *type,
 void
 CallExpr::initTmp() const
 {
-    auto tmpAddr = gen::localVariableDefinition(tmpId.c_str(), type);
-    gen::store(loadValue(), tmpAddr);
+    initialize(gen::localVariableDefinition(tmpId.c_str(), type));
 }
 
 ExprPtr
@@ -66,13 +66,11 @@ CallExpr::loadConstant() const
 gen::Value
 CallExpr::loadValue() const
 {
-    std::vector<gen::Value> argValue;
-    for (const auto &a : arg) {
-	argValue.push_back(a->loadValue());
+    if (!type->isScalar()) {
+	// aggregates are returned in memory
+	return gen::fetch(loadAddress(), type);
     }
-    auto fnAddr = fn->loadAddress();
-    auto call = gen::functionCall(fnAddr, fn->type, argValue);
-    return call;
+    return call(nullptr);
 }
 
 gen::Value
@@ -82,6 +80,51 @@ CallExpr::loadAddress() const
     return gen::loadAddress(tmpId.c_str());
 }
 
+void
+CallExpr::initialize(gen::Value addr) const
+{
+    call(addr);
+}
+
+gen::Value
+CallExpr::call(gen::Value retAddr) const
+{
+    auto argValue = loadArg();
+    auto fnAddr = fn->loadAddress();
+    // call site for stack traces, arguments may contain calls in other lines
+    gen::debugLocation(loc.path.c_str(), loc.from.line, loc.from.col);
+    return gen::functionCall(fnAddr, fn->type, argValue, retAddr);
+}
+
+void
+CallExpr::tailCall() const
+{
+    auto argValue = loadArg();
+    auto fnAddr = fn->loadAddress();
+    gen::debugLocation(loc.path.c_str(), loc.from.line, loc.from.col);
+    gen::tailCall(fnAddr, fn->type, argValue);
+}
+
+std::vector<gen::Value>
+CallExpr::loadArg() const
+{
+    std::vector<gen::Value> argValue;
+    for (std::size_t i = 0; i < arg.size(); ++i) {
+	if (i < fn->type->paramType().size() && !arg[i]->type->isScalar()) {
+	    // passed as address of a copy, see gen::functionCall()
+	    std::stringstream ss;
+	    ss << tmpId.c_str() << ".arg" << i;
+	    auto argId = UStr::create(ss.str()).c_str();
+	    auto argAddr = gen::localVariableDefinition(argId, arg[i]->type);
+	    arg[i]->storeValue(argAddr);
+	    argValue.push_back(argAddr);
+	} else {
+	    argValue.push_back(arg[i]->loadValue());
+	}
+    }
+    return argValue;
+}
+
 // for debugging and educational purposes
 void
 CallExpr::print(int indent) const
@@ -14,6 +14,8 @@ class CallExpr : public Expr
 	UStr tmpId;
 
 	void initTmp() const;
+	std::vector<gen::Value> loadArg() const;
+	gen::Value call(gen::Value retAddr) const;
 
     public:
 	static ExprPtr create(ExprPtr &&fn, std::vector<ExprPtr> &&arg,
@@ -30,6 +32,12 @@ class CallExpr : public Expr
 	gen::Constant loadConstant() const override;
 	gen::Value loadValue() const override;
 	gen::Value loadAddress() const override;
+	// stores the result at 'addr'. A result returned in a slot is
+	// directly returned there.
+	void initialize(gen::Value addr) const;
+	// call with 'musttail' that returns from the current function, see
+	// gen::tailCall()
+	void tailCall() const;
 
 	// for debugging and educational purposes
 	void print(int indent) const override;
@@ -3,6 +3,7 @@
 #include <sstream>
 
 #include "gen/constant.hpp"
+#include "gen/gentype.hpp"
 #include "gen/variable.hpp"
 #include "lexer/error.hpp"
 #include "type/integertype.hpp"
@@ -12,7 +13,8 @@
 
 namespace abc {
 
-CompoundExpr::CompoundExpr(std::vector<ExprPtr> &&expr, const Type *type,
+CompoundExpr::CompoundExpr(std::map<std::size_t, ExprPtr> &&expr,
+                           const Type *type,
                            std::vector<Designator> &&designator,
                            std::vector<const Expr *> &&parsedExpr,
                            lexer::Loc loc)
@@ -28,30 +30,21 @@ CompoundExpr::CompoundExpr(std::vector<ExprPtr> &&expr, const Type *type,
 void
 CompoundExpr::initTmp() const
 {
-    auto tmpAddr = gen::localVariableDefinition(tmpId.c_str(), type);
+    initialize(gen::localVariableDefinition(tmpId.c_str(), type));
+}
 
-    std::vector<gen::Value> val{type->aggregateSize()};
-    for (std::size_t i = 0; i < type->aggregateSize(); ++i) {
-	val[i] = loadValue(i);
-    }
+bool
+CompoundExpr::isZero(std::size_t index) const
+{
+    auto e = element(index);
+    return !e || (e->isConst() && e->loadConstant()->isNullValue());
+}
 
-    if (type->isScalar()) {
-	gen::store(val[0], tmpAddr);
-    } else if (type->isArray()) {
-	for (std::size_t i = 0; i < type->dim(); ++i) {
-	    auto index = gen::getConstantInt(i, IntegerType::createSizeType());
-	    auto elementAddr =
-	        gen::pointerIncrement(type->refType(), tmpAddr, index);
-	    gen::store(val[i], elementAddr);
-	}
-    } else if (type->isStruct()) {
-	for (std::size_t i = 0; i < type->aggregateSize(); ++i) {
-	    auto memberAddr = gen::pointerToIndex(type, tmpAddr, i);
-	    gen::store(val[i], memberAddr);
-	}
-    } else {
-	assert(0);
-    }
+const Expr *
+CompoundExpr::element(std::size_t index) const
+{
+    auto it = expr.find(index);
+    return it != expr.end() ? it->second.get() : nullptr;
 }
 
 ExprPtr
@@ -63,7 +56,7 @@ CompoundExpr::create(std::vector<Designator> &&designator,
     assert(type->hasSize());
     assert(!designator.size() || designator.size() == parsedExpr.size());
 
-    std::vector<ExprPtr> expr(type->aggregateSize());
+    std::map<std::size_t, ExprPtr> expr;
     std::vector<const Expr *> parsedExpr_;
     for (std::size_t i = 0, index = 0; i < parsedExpr.size(); ++i, ++index) {
 	auto ty = type->aggregateType(i);
@@ -80,7 +73,7 @@ CompoundExpr::create(std::vector<Designator> &&designator,
 		index = std::get<ExprPtr>(designator[i])->getUnsignedIntValue();
 	    }
 	}
-	if (expr[index]) {
+	if (expr.contains(index)) {
 	    error::location(parsedExpr[i]->loc);
 	    error::out() << error::setColor(error::BOLD) << parsedExpr[i]->loc
 	                 << ": " << error::setColor(error::BOLD_BLUE)
@@ -123,8 +116,8 @@ CompoundExpr::isLValue() const
 bool
 CompoundExpr::isConst() const
 {
-    for (const auto &e : expr) {
-	if (e && !e->isConst()) {
+    for (const auto &[index, e] : expr) {
+	if (!e->isConst()) {
 	    return false;
 	}
     }
@@ -138,19 +131,20 @@ CompoundExpr::loadConstant() const
     assert(isConst());
     assert(type);
 
-    std::vector<gen::Constant> val{type->aggregateSize()};
-    for (std::size_t i = 0; i < type->aggregateSize(); ++i) {
-	if (expr[i]) {
-	    val[i] = expr[i]->loadConstant();
-	} else {
-	    val[i] = gen::getConstantZero(type->aggregateType(i));
-	}
-    }
     if (type->isScalar()) {
-	return val[0];
+	return loadConstant(0);
     } else if (type->isArray()) {
+	// only initialized elements are passed, the array can be huge
+	std::map<std::size_t, gen::Constant> val;
+	for (const auto &[index, e] : expr) {
+	    val[index] = e->loadConstant();
+	}
 	return gen::getConstantArray(val, type);
     } else if (type->isStruct()) {
+	std::vector<gen::Constant> val{type->aggregateSize()};
+	for (std::size_t i = 0; i < type->aggregateSize(); ++i) {
+	    val[i] = loadConstant(i);
+	}
 	return gen::getConstantStruct(val, type);
     } else {
 	assert(0);
@@ -161,6 +155,16 @@ CompoundExpr::loadConstant() const
 gen::Value
 CompoundExpr::loadValue() const
 {
+    if (isConst()) {
+	// the constant of a sparse array initializer has not the type of
+	// the array. In this case the value is loaded from a read-only
+	// object.
+	auto val = loadConstant();
+	if (val->getType() == gen::convert(type)) {
+	    return val;
+	}
+	return gen::fetch(gen::loadReadonlyAddress(val, type), type);
+    }
     return gen::fetch(loadAddress(), type);
 }
 
@@ -175,8 +179,8 @@ gen::Constant
 CompoundExpr::loadConstant(std::size_t index) const
 {
     assert(index < type->aggregateSize());
-    if (expr[index]) {
-	return expr[index]->loadConstant();
+    if (auto e = element(index)) {
+	return e->loadConstant();
     } else {
 	return gen::getConstantZero(type->aggregateType(index));
     }
@@ -185,13 +189,77 @@ CompoundExpr::loadConstant(std::size_t index) const
 gen::Value
 CompoundExpr::loadValue(std::size_t index) const
 {
-    if (expr[index]) {
-	return expr[index]->loadValue();
+    if (auto e = element(index)) {
+	return e->loadValue();
     } else {
 	return gen::getConstantZero(type->aggregateType(index));
     }
 }
 
+void
+CompoundExpr::initialize(gen::Value addr) const
+{
+    if (type->isScalar()) {
+	initialize(0, addr);
+	return;
+    }
+    // a constant compound is copied from a read-only object
+    if (isConst()) {
+	auto val = loadConstant();
+	if (val->isNullValue()) {
+	    gen::zero(addr, type);
+	} else {
+	    gen::copy(addr, gen::loadReadonlyAddress(val, type), type);
+	}
+	return;
+    }
+
+    // if most elements are zero the memory gets cleared first and only the
+    // other elements are stored
+    std::size_t numNonZero = 0;
+    for (const auto &[index, e] : expr) {
+	numNonZero += !isZero(index);
+    }
+    bool clear = 2 * numNonZero < type->aggregateSize();
+    std::vector<std::size_t> initIndex;
+    if (clear) {
+	gen::zero(addr, type);
+	for (const auto &[index, e] : expr) {
+	    if (!isZero(index)) {
+		initIndex.push_back(index);
+	    }
+	}
+    } else {
+	for (std::size_t i = 0; i < type->aggregateSize(); ++i) {
+	    initIndex.push_back(i);
+	}
+    }
+
+    for (auto i : initIndex) {
+	if (type->isArray()) {
+	    auto index = gen::getConstantInt(i, IntegerType::createSizeType());
+	    initialize(i, gen::pointerIncrement(type->refType(), addr, index));
+	} else if (type->isStruct()) {
+	    initialize(i, gen::pointerToIndex(type, addr, i));
+	} else {
+	    assert(0);
+	}
+    }
+}
+
+void
+CompoundExpr::initialize(std::size_t index, gen::Value addr) const
+{
+    auto compExpr = dynamic_cast<const CompoundExpr *>(element(index));
+    if (compExpr) {
+	compExpr->initialize(addr);
+    } else if (auto e = element(index)) {
+	e->storeValue(addr);
+    } else {
+	gen::store(loadValue(index), addr);
+    }
+}
+
 // for debugging and educational purposes
 void
 CompoundExpr::print(int indent) const
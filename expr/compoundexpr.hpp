@@ -1,6 +1,7 @@
 #ifndef EXPR_COMPOUNDEXPR_HPP
 #define EXPR_COMPOUNDEXPR_HPP
 
+#include <map>
 #include <optional>
 #include <variant>
 #include <vector>
@@ -24,7 +25,7 @@ class CompoundExpr : public Expr
 	using Designator = std::variant<lexer::Token, ExprPtr, std::nullopt_t>;
 
     protected:
-	CompoundExpr(std::vector<ExprPtr> &&expr, const Type *type,
+	CompoundExpr(std::map<std::size_t, ExprPtr> &&expr, const Type *type,
 	             std::vector<Designator> &&designator,
 	             std::vector<const Expr *> &&parsedExpr, lexer::Loc loc);
 
@@ -35,6 +36,7 @@ class CompoundExpr : public Expr
 	const std::vector<const Expr *> parsedExpr;
 
 	void initTmp() const;
+	bool isZero(std::size_t index) const;
 
     public:
 	static ExprPtr create(std::vector<Designator> &&designator,
@@ -42,7 +44,9 @@ class CompoundExpr : public Expr
 	                      const Type *type, lexer::Loc loc = lexer::Loc{});
 	void setDisplayOpt(DisplayOpt opt) const;
 
-	const std::vector<ExprPtr> expr;
+	// initialized elements by index. Elements without an entry are zero.
+	const std::map<std::size_t, ExprPtr> expr;
+	const Expr *element(std::size_t index) const;
 
 	bool hasAddress() const override;
 	bool isLValue() const override;
@@ -56,6 +60,11 @@ class CompoundExpr : public Expr
 	gen::Constant loadConstant(std::size_t index) const;
 	gen::Value loadValue(std::size_t index) const;
 
+	// store the value of the compound (or of an element) in the object at
+	// 'addr'
+	void initialize(gen::Value addr) const;
+	void initialize(std::size_t index, gen::Value addr) const;
+
 	// for debugging and educational purposes
 	void print(int indent) const override;
 
@@ -74,6 +74,9 @@ ConditionalExpr::isConst() const
     if (!cond->isConst()) {
 	return false;
     }
+    // also called by the parser while code is generated for earlier
+    // declarations
+    std::lock_guard lock{gen::llvmContextMutex};
     auto condValue = gen::instruction(gen::NE, cond->loadConstant(),
                                       gen::getConstantZero(cond->type));
     if (!condValue->isNullValue()) {
@@ -83,6 +86,21 @@ ConditionalExpr::isConst() const
     }
 }
 
+std::optional<std::size_t>
+ConditionalExpr::speculationCost() const
+{
+    if (isConst()) {
+	return 0;
+    }
+    auto condCost = cond->speculationCost();
+    auto trueCost = trueExpr->speculationCost();
+    auto falseCost = falseExpr->speculationCost();
+    if (!condCost || !trueCost || !falseCost) {
+	return std::nullopt;
+    }
+    return condCost.value() + trueCost.value() + falseCost.value() + 1;
+}
+
 // for code generation
 gen::Constant
 ConditionalExpr::loadConstant() const
@@ -101,6 +119,16 @@ gen::Value
 ConditionalExpr::loadValue() const
 {
     assert(type);
+    if (type->isScalar() && trueExpr->isCheap() && falseExpr->isCheap()) {
+	// evaluating both alternatives is cheaper than branching
+	auto condValue = cond->loadValue();
+	if (!cond->type->isBool()) {
+	    auto zero = gen::getConstantZero(cond->type);
+	    condValue = gen::instruction(gen::NE, condValue, zero);
+	}
+	return gen::select(condValue, trueExpr->loadValue(),
+	                   falseExpr->loadValue());
+    }
     auto thenLabel = gen::getLabel("condTrue");
     auto elseLabel = gen::getLabel("condFalse");
     auto endLabel = gen::getLabel("end");
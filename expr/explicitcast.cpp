@@ -75,6 +75,18 @@ ExplicitCast::isConst() const
     }
 }
 
+std::optional<std::size_t>
+ExplicitCast::speculationCost() const
+{
+    if (isConst()) {
+	return 0;
+    } else if (!type->isScalar() || !expr->type->isScalar()) {
+	return std::nullopt;
+    }
+    auto cost = expr->speculationCost();
+    return cost ? std::optional{cost.value() + 1} : std::nullopt;
+}
+
 // for code generation
 gen::Constant
 ExplicitCast::loadConstant() const
@@ -19,6 +19,7 @@ class ExplicitCast : public Expr
 	bool hasAddress() const override;
 	bool isLValue() const override;
 	bool isConst() const override;
+	std::optional<std::size_t> speculationCost() const override;
 
 	// for code generation
 	gen::Constant loadConstant() const override;
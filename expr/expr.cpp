@@ -1,5 +1,7 @@
 #include "gen/constant.hpp"
+#include "gen/gentype.hpp"
 #include "gen/instruction.hpp"
+#include "gen/variable.hpp"
 #include "lexer/error.hpp"
 
 #include "expr.hpp"
@@ -14,6 +16,23 @@ Expr::hasConstantAddress() const
     return false;
 }
 
+std::optional<std::size_t>
+Expr::speculationCost() const
+{
+    if (isConst()) {
+	return 0;
+    }
+    return std::nullopt;
+}
+
+bool
+Expr::isCheap() const
+{
+    static const std::size_t maxCost = 4;
+    auto cost = speculationCost();
+    return cost && cost.value() <= maxCost;
+}
+
 gen::Constant
 Expr::loadConstantAddress() const
 {
@@ -38,11 +57,22 @@ Expr::condition(gen::Label trueLabel, gen::Label falseLabel) const
     gen::jumpInstruction(cond, trueLabel, falseLabel);
 }
 
+void
+Expr::storeValue(gen::Value addr) const
+{
+    if (gen::isLargeAggregate(type) && hasAddress()) {
+	gen::copy(addr, loadAddress(), type);
+    } else {
+	gen::store(loadValue(), addr);
+    }
+}
+
 gen::ConstantInt
 Expr::getConstantInt() const
 {
     assert(isConst());
     assert(type->isInteger());
+    std::lock_guard lock{gen::llvmContextMutex};
     using T = std::remove_pointer_t<gen::ConstantInt>;
     auto check = llvm::dyn_cast<T>(loadConstant());
     assert(check);
@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <optional>
 
 #include "gen/gen.hpp"
 #include "lexer/loc.hpp"
@@ -26,6 +27,12 @@ class Expr
 	virtual bool hasAddress() const = 0;
 	virtual bool isLValue() const = 0;
 	virtual bool isConst() const = 0;
+	// Rough number of instructions for evaluating the expression if it has
+	// no side effects and can not trap, otherwise std::nullopt. Cheap
+	// expressions of this kind are evaluated speculatively instead of
+	// branching around them.
+	virtual std::optional<std::size_t> speculationCost() const;
+	bool isCheap() const;
 
 	// for code generation
 	virtual gen::Constant loadConstant() const = 0;
@@ -34,6 +41,8 @@ class Expr
 	virtual gen::Value loadAddress() const = 0;
 	virtual void condition(gen::Label trueLabel,
 	                       gen::Label falseLabel) const;
+	// stores the value at 'addr'. Large aggregates are copied with memcpy.
+	void storeValue(gen::Value addr) const;
 
 	// for debugging and educational purposes
 	virtual void print(int indent = 1) const = 0;
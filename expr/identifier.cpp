@@ -49,6 +49,18 @@ Identifier::isConst() const
     return false;
 }
 
+std::optional<std::size_t>
+Identifier::speculationCost() const
+{
+    if (type->isFunction()) {
+	return 0;
+    } else if (type->isScalar()) {
+	// a variable can always be loaded
+	return 1;
+    }
+    return std::nullopt;
+}
+
 // for code generation
 gen::Constant
 Identifier::loadConstant() const
@@ -3,6 +3,7 @@
 
 #include "gen/cast.hpp"
 #include "gen/constant.hpp"
+#include "gen/gentype.hpp"
 #include "gen/instruction.hpp"
 #include "gen/variable.hpp"
 #include "lexer/error.hpp"
@@ -91,6 +92,18 @@ ImplicitCast::isConst() const
     }
 }
 
+std::optional<std::size_t>
+ImplicitCast::speculationCost() const
+{
+    if (isConst()) {
+	return 0;
+    } else if (!type->isScalar() || !expr->type->isScalar()) {
+	return std::nullopt;
+    }
+    auto cost = expr->speculationCost();
+    return cost ? std::optional{cost.value() + 1} : std::nullopt;
+}
+
 // for code generation
 gen::Constant
 ImplicitCast::loadConstant() const
@@ -144,6 +157,10 @@ ImplicitCast::loadValue() const
 gen::Value
 ImplicitCast::loadAddress() const
 {
+    // aggregates only differ by qualifiers, a copy is not needed
+    if (gen::isLargeAggregate(type) && expr->hasAddress()) {
+	return expr->loadAddress();
+    }
     static std::size_t idCount;
     std::stringstream ss;
     ss << ".compound" << idCount++;
@@ -0,0 +1,40 @@
+#ifndef EXPR_LABELADDRESS_HPP
+#define EXPR_LABELADDRESS_HPP
+
+#include "expr.hpp"
+#include "lexer/loc.hpp"
+
+namespace abc {
+
+// '&&label' is the address of a label within the current function. It can be
+// used as target of 'goto *expr'.
+class LabelAddress : public Expr
+{
+    protected:
+	LabelAddress(UStr labelName, lexer::Loc loc);
+
+    public:
+	static ExprPtr create(UStr labelName, lexer::Loc loc = lexer::Loc{});
+
+	const UStr labelName;
+
+	// for sematic checks
+	bool hasAddress() const override;
+	bool isLValue() const override;
+	bool isConst() const override;
+
+	// for code generation
+	gen::Constant loadConstant() const override;
+	gen::Value loadValue() const override;
+	gen::Value loadAddress() const override;
+
+	// for debugging and educational purposes
+	void print(int indent) const override;
+
+	// for printing error messages
+	void printFlat(std::ostream &out, int prec) const override;
+};
+
+} // namespace abc
+
+#endif // EXPR_LABELADDRESS_HPP
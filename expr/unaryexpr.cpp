@@ -86,6 +86,19 @@ UnaryExpr::isConst() const
     }
 }
 
+std::optional<std::size_t>
+UnaryExpr::speculationCost() const
+{
+    if (isConst()) {
+	return 0;
+    } else if (kind != LOGICAL_NOT && kind != MINUS) {
+	// dereferencing can trap, increment and decrement modify the operand
+	return std::nullopt;
+    }
+    auto cost = child->speculationCost();
+    return cost ? std::optional{cost.value() + 1} : std::nullopt;
+}
+
 gen::Constant
 UnaryExpr::loadConstant() const
 {
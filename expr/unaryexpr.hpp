@@ -43,6 +43,7 @@ class UnaryExpr : public Expr
 
     public:
 	bool isConst() const override;
+	std::optional<std::size_t> speculationCost() const override;
 
 	// for code generation
 	gen::Constant loadConstant() const override;
@@ -0,0 +1,405 @@
+#include <array>
+#include <functional>
+#include <unordered_map>
+
+#include "abi.hpp"
+#include "function.hpp"
+#include "gentype.hpp"
+#include "instruction.hpp"
+
+namespace gen {
+
+static std::unordered_map<const abc::Type *, FunctionInfo> functionInfoMap;
+
+void
+initFunctionInfo()
+{
+    functionInfoMap.clear();
+}
+
+//------------------------------------------------------------------------------
+
+// Calls 'op' for each scalar within 'type' with its offset in bytes
+static void
+forEachScalar(const abc::Type *type, std::uint64_t offset,
+              const std::function<void(const abc::Type *, std::uint64_t)> &op)
+{
+    if (type->isArray()) {
+	auto size = getSizeof(type->refType());
+	for (std::size_t i = 0; i < type->dim(); ++i) {
+	    forEachScalar(type->refType(), offset + i * size, op);
+	}
+    } else if (type->isStruct()) {
+	auto llvmType = llvm::cast<llvm::StructType>(convert(type));
+	auto layout = llvmModule->getDataLayout().getStructLayout(llvmType);
+	const auto &memberType = type->memberType();
+	const auto &memberIndex = type->memberIndex();
+	for (std::size_t i = 0; i < memberType.size(); ++i) {
+	    auto index = getElementIndex(llvmType, memberIndex[i]);
+	    forEachScalar(memberType[i],
+	                  offset + layout->getElementOffset(index), op);
+	}
+    } else {
+	op(type, offset);
+    }
+}
+
+static llvm::Attribute::AttrKind
+getExtension(const abc::Type *type)
+{
+    if (!type->isInteger() || type->numBits() >= 32) {
+	return llvm::Attribute::None;
+    }
+    return type->isSignedInteger() ? llvm::Attribute::SExt
+                                   : llvm::Attribute::ZExt;
+}
+
+/*
+ * x86-64 System V ABI: Aggregates up to 16 bytes are split into eightbytes.
+ * Each eightbyte is passed in an integer register, or in an SSE register if
+ * it only contains floating point values. Larger or unaligned aggregates
+ * are passed on the stack and returned in memory.
+ */
+
+// registers available for parameters
+struct RegisterCount
+{
+	unsigned integer = 6;
+	unsigned sse = 8;
+};
+
+static ArgInfo
+classifyX86_64(const abc::Type *type, bool isReturn, RegisterCount &free)
+{
+    if (type->isVoid()) {
+	return ArgInfo{};
+    } else if (type->isScalar()) {
+	auto &count = type->isFloatType() ? free.sse : free.integer;
+	auto needed = type->numBits() > 64 ? 2u : 1u;
+	if (!isReturn) {
+	    count -= std::min(count, needed);
+	}
+	return ArgInfo{ArgInfo::DIRECT, nullptr, getExtension(type)};
+    }
+
+    auto size = getSizeof(type);
+    if (size == 0) {
+	return ArgInfo{};
+    }
+    auto inMemory = ArgInfo{isReturn ? ArgInfo::SRET : ArgInfo::BYVAL};
+    if (size > 16) {
+	return inMemory;
+    }
+
+    enum Class
+    {
+	NO_CLASS,
+	INTEGER,
+	SSE,
+    };
+    std::array<Class, 2> cls{NO_CLASS, NO_CLASS};
+    std::array<bool, 2> hasDouble{false, false};
+    bool unaligned = false;
+    forEachScalar(type, 0, [&](const abc::Type *ty, std::uint64_t offset) {
+	unaligned = unaligned || offset % getAlignof(ty);
+	auto &c = cls[offset / 8];
+	if (!ty->isFloatType()) {
+	    c = INTEGER;
+	} else if (c == NO_CLASS) {
+	    c = SSE;
+	}
+	hasDouble[offset / 8] = hasDouble[offset / 8] || ty->isDouble();
+    });
+    if (unaligned) {
+	return inMemory;
+    }
+
+    auto numEightbytes = size > 8 ? 2u : 1u;
+    if (numEightbytes == 2 && cls[0] == NO_CLASS) {
+	cls[0] = INTEGER;
+    } else if (numEightbytes == 2 && cls[1] == NO_CLASS) {
+	// only padding
+	numEightbytes = 1;
+    }
+    if (!isReturn) {
+	auto numInteger = unsigned(cls[0] == INTEGER) + (cls[1] == INTEGER);
+	auto numSse = unsigned(cls[0] == SSE) + (cls[1] == SSE);
+	if (numInteger > free.integer || numSse > free.sse) {
+	    // the aggregate is not split between registers and stack
+	    return inMemory;
+	}
+	free.integer -= numInteger;
+	free.sse -= numSse;
+    }
+
+    std::vector<llvm::Type *> part;
+    for (std::size_t i = 0; i < numEightbytes; ++i) {
+	auto numBytes = std::min<std::uint64_t>(8, size - 8 * i);
+	if (cls[i] != SSE) {
+	    part.push_back(llvm::IntegerType::get(*llvmContext, 8 * numBytes));
+	} else if (numBytes <= 4) {
+	    part.push_back(llvm::Type::getFloatTy(*llvmContext));
+	} else if (hasDouble[i]) {
+	    part.push_back(llvm::Type::getDoubleTy(*llvmContext));
+	} else {
+	    auto floatType = llvm::Type::getFloatTy(*llvmContext);
+	    part.push_back(llvm::FixedVectorType::get(floatType, 2));
+	}
+    }
+    auto coerceType = part.size() == 1
+                          ? part[0]
+                          : llvm::StructType::get(*llvmContext, part);
+    return ArgInfo{ArgInfo::COERCE, coerceType};
+}
+
+/*
+ * AArch64 procedure call standard (AAPCS64): Homogeneous floating point
+ * aggregates (up to four floats or doubles) are passed in floating point
+ * registers. Other aggregates up to 16 bytes are passed in up to two general
+ * purpose registers, larger ones by reference to a copy.
+ */
+
+static ArgInfo
+classifyAArch64(const abc::Type *type, bool isReturn, bool isDarwin)
+{
+    if (type->isVoid()) {
+	return ArgInfo{};
+    } else if (type->isScalar()) {
+	// only Apple requires the caller to extend small integers
+	auto ext = isDarwin ? getExtension(type) : llvm::Attribute::None;
+	return ArgInfo{ArgInfo::DIRECT, nullptr, ext};
+    }
+
+    auto size = getSizeof(type);
+    if (size == 0) {
+	return ArgInfo{};
+    }
+    if (size <= 32) {
+	const abc::Type *elementType = nullptr;
+	std::size_t numElements = 0;
+	bool homogeneous = true;
+	forEachScalar(type, 0, [&](const abc::Type *ty, std::uint64_t) {
+	    if (!elementType) {
+		elementType = ty;
+	    }
+	    homogeneous = homogeneous && ty->isFloatType() &&
+	                  ty->isDouble() == elementType->isDouble();
+	    ++numElements;
+	});
+	if (homogeneous && numElements <= 4 &&
+	    numElements * getSizeof(elementType) == size) {
+	    auto coerceType =
+	        llvm::ArrayType::get(convert(elementType), numElements);
+	    return ArgInfo{ArgInfo::COERCE, coerceType};
+	}
+    }
+    if (size > 16) {
+	return ArgInfo{isReturn ? ArgInfo::SRET : ArgInfo::INDIRECT};
+    }
+
+    auto i64Type = llvm::Type::getInt64Ty(*llvmContext);
+    llvm::Type *coerceType = nullptr;
+    if (size <= 8) {
+	coerceType = i64Type;
+    } else if (getAlignof(type) == 16) {
+	coerceType = llvm::Type::getInt128Ty(*llvmContext);
+    } else {
+	coerceType = llvm::ArrayType::get(i64Type, 2);
+    }
+    return ArgInfo{ArgInfo::COERCE, coerceType};
+}
+
+// For other targets aggregates are passed as LLVM aggregates unless they are
+// large
+static ArgInfo
+classifyGeneric(const abc::Type *type, bool isReturn)
+{
+    if (type->isScalar() || !isLargeAggregate(type)) {
+	return ArgInfo{};
+    }
+    return ArgInfo{isReturn ? ArgInfo::SRET : ArgInfo::INDIRECT};
+}
+
+//------------------------------------------------------------------------------
+
+const FunctionInfo &
+getFunctionInfo(const abc::Type *fnType)
+{
+    assert(fnType);
+    assert(fnType->isFunction());
+    assert(targetMachine);
+
+    if (functionInfoMap.contains(fnType)) {
+	return functionInfoMap.at(fnType);
+    }
+
+    const auto &triple = targetMachine->getTargetTriple();
+    bool isX86_64 = triple.getArch() == llvm::Triple::x86_64 &&
+                    !triple.isOSWindows();
+    RegisterCount free;
+    auto classify = [&](const abc::Type *type, bool isReturn) {
+	if (isX86_64) {
+	    return classifyX86_64(type, isReturn, free);
+	} else if (triple.isAArch64()) {
+	    return classifyAArch64(type, isReturn, triple.isOSDarwin());
+	}
+	return classifyGeneric(type, isReturn);
+    };
+
+    FunctionInfo info;
+    auto ptrType = llvm::PointerType::get(*llvmContext, 0);
+    std::vector<llvm::Type *> llvmParamType;
+
+    info.ret = classify(fnType->retType(), true);
+    llvm::Type *llvmRetType = nullptr;
+    switch (info.ret.kind) {
+    case ArgInfo::SRET:
+	llvmRetType = llvm::Type::getVoidTy(*llvmContext);
+	llvmParamType.push_back(ptrType);
+	info.argOffset = 1;
+	--free.integer;
+	break;
+    case ArgInfo::COERCE:
+	llvmRetType = info.ret.coerceType;
+	break;
+    default:
+	llvmRetType = convert(fnType->retType());
+	break;
+    }
+
+    for (auto paramType : fnType->paramType()) {
+	info.param.push_back(classify(paramType, false));
+	switch (info.param.back().kind) {
+	case ArgInfo::COERCE:
+	    llvmParamType.push_back(info.param.back().coerceType);
+	    break;
+	case ArgInfo::INDIRECT:
+	case ArgInfo::BYVAL:
+	    llvmParamType.push_back(ptrType);
+	    break;
+	default:
+	    llvmParamType.push_back(convert(paramType));
+	    break;
+	}
+    }
+    info.llvmFnType =
+        llvm::FunctionType::get(llvmRetType, llvmParamType, fnType->hasVarg());
+    return functionInfoMap[fnType] = std::move(info);
+}
+
+// Attributes are required for the function and each call
+template <typename T>
+static void
+addAttributes(T *fnOrCall, const abc::Type *fnType)
+{
+    const auto &info = getFunctionInfo(fnType);
+
+    if (info.ret.kind == ArgInfo::SRET) {
+	auto llvmRetType = convert(fnType->retType());
+	auto align = getAlignment(llvmRetType);
+	fnOrCall->addParamAttr(0, llvm::Attribute::getWithStructRetType(
+	                              *llvmContext, llvmRetType));
+	fnOrCall->addParamAttr(0, llvm::Attribute::NoAlias);
+	fnOrCall->addParamAttr(
+	    0, llvm::Attribute::getWithAlignment(*llvmContext, align));
+    } else if (info.ret.ext != llvm::Attribute::None) {
+	fnOrCall->addRetAttr(info.ret.ext);
+    }
+
+    const auto &paramType = fnType->paramType();
+    for (std::size_t i = 0; i < paramType.size(); ++i) {
+	auto argNo = i + info.argOffset;
+	auto llvmType = convert(paramType[i]);
+	auto align = getAlignment(llvmType);
+	switch (info.param[i].kind) {
+	case ArgInfo::INDIRECT:
+	    fnOrCall->addParamAttr(argNo, llvm::Attribute::NoAlias);
+	    fnOrCall->addParamAttr(
+	        argNo, llvm::Attribute::getWithAlignment(*llvmContext, align));
+	    fnOrCall->addParamAttr(
+	        argNo, llvm::Attribute::getWithDereferenceableBytes(
+	                   *llvmContext, getSizeof(paramType[i])));
+	    break;
+	case ArgInfo::BYVAL:
+	    // stack slots are at least 8 byte aligned
+	    align = std::max(align, llvm::Align(8));
+	    fnOrCall->addParamAttr(argNo, llvm::Attribute::getWithByValType(
+	                                      *llvmContext, llvmType));
+	    fnOrCall->addParamAttr(
+	        argNo, llvm::Attribute::getWithAlignment(*llvmContext, align));
+	    break;
+	default:
+	    if (info.param[i].ext != llvm::Attribute::None) {
+		fnOrCall->addParamAttr(argNo, info.param[i].ext);
+	    }
+	    break;
+	}
+    }
+}
+
+void
+setAttributes(llvm::Function *fn, const abc::Type *fnType)
+{
+    addAttributes(fn, fnType);
+}
+
+void
+setAttributes(llvm::CallInst *call, const abc::Type *fnType)
+{
+    addAttributes(call, fnType);
+}
+
+//------------------------------------------------------------------------------
+
+static llvm::AllocaInst *
+createTemporary(llvm::Type *type, llvm::Align align)
+{
+    assert(functionBuildingInfo.fn);
+
+    // always allocate memory at entry of function
+    auto fn = functionBuildingInfo.fn;
+    llvm::IRBuilder<> tmpBuilder(&fn->getEntryBlock(),
+                                 fn->getEntryBlock().begin());
+    auto tmp = tmpBuilder.CreateAlloca(type);
+    tmp->setAlignment(std::max(tmp->getAlign(), align));
+    return tmp;
+}
+
+Value
+loadCoerced(Value addr, const abc::Type *type, llvm::Type *coerceType)
+{
+    assert(llvmBuilder);
+    reachableCheck();
+
+    auto &dl = llvmModule->getDataLayout();
+    auto size = getSizeof(type);
+    auto align = getAlignment(convert(type));
+    if (dl.getTypeAllocSize(coerceType) > size) {
+	// e.g. a 12 byte struct passed as [2 x i64]. Reading beyond the
+	// object is avoided by copying it into a temporary.
+	auto tmp = createTemporary(coerceType, align);
+	llvmBuilder->CreateMemCpy(tmp, tmp->getAlign(), addr, align, size);
+	return llvmBuilder->CreateAlignedLoad(coerceType, tmp, tmp->getAlign());
+    }
+    return llvmBuilder->CreateAlignedLoad(coerceType, addr, align);
+}
+
+void
+storeCoerced(Value val, Value addr, const abc::Type *type)
+{
+    assert(llvmBuilder);
+    reachableCheck();
+
+    auto &dl = llvmModule->getDataLayout();
+    auto size = getSizeof(type);
+    auto align = getAlignment(convert(type));
+    if (dl.getTypeAllocSize(val->getType()) > size) {
+	auto tmp = createTemporary(val->getType(), align);
+	llvmBuilder->CreateAlignedStore(val, tmp, tmp->getAlign());
+	llvmBuilder->CreateMemCpy(addr, align, tmp, tmp->getAlign(), size);
+	return;
+    }
+    llvmBuilder->CreateAlignedStore(val, addr, align);
+}
+
+} // namespace gen
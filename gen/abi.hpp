@@ -0,0 +1,67 @@
+#ifndef GEN_ABI_HPP
+#define GEN_ABI_HPP
+
+#include <vector>
+
+#ifdef SUPPORT_SOLARIS
+// has to be included as first llvm header
+#include "llvm/Support/Solaris/sys/regset.h"
+#endif // SUPPORT_SOLARIS
+
+#include "llvm/IR/Attributes.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+
+#include "type/type.hpp"
+
+#include "gen.hpp"
+
+namespace gen {
+
+// How a parameter or the return value is passed on LLVM level. This follows
+// the C calling convention of the target such that ABC and C functions can
+// call each other.
+struct ArgInfo
+{
+	enum Kind
+	{
+	    DIRECT,   // as value of the converted type
+	    COERCE,   // as value of 'coerceType', e.g. a small struct that is
+	              // passed in registers
+	    INDIRECT, // as pointer to a copy allocated by the caller
+	    BYVAL,    // as pointer with 'byval' attribute, i.e. on the stack
+	    SRET,     // return value in a slot provided by the caller
+	};
+
+	Kind kind = DIRECT;
+	llvm::Type *coerceType = nullptr;
+	// zeroext or signext for small integers
+	llvm::Attribute::AttrKind ext = llvm::Attribute::None;
+
+	bool operator==(const ArgInfo &) const = default;
+};
+
+struct FunctionInfo
+{
+	llvm::FunctionType *llvmFnType = nullptr;
+	ArgInfo ret;
+	std::vector<ArgInfo> param;
+	// LLVM argument number of the first parameter. It is 1 if the return
+	// value is stored in a slot, otherwise 0.
+	unsigned argOffset = 0;
+};
+
+void initFunctionInfo();
+const FunctionInfo &getFunctionInfo(const abc::Type *fnType);
+
+void setAttributes(llvm::Function *fn, const abc::Type *fnType);
+void setAttributes(llvm::CallInst *call, const abc::Type *fnType);
+
+// Conversion between an object of type 'type' in memory and its coerced value
+Value loadCoerced(Value addr, const abc::Type *type, llvm::Type *coerceType);
+void storeCoerced(Value val, Value addr, const abc::Type *type);
+
+} // namespace gen
+
+#endif // GEN_ABI_HPP
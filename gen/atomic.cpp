@@ -0,0 +1,144 @@
+#include "atomic.hpp"
+#include "function.hpp"
+#include "gentype.hpp"
+#include "instruction.hpp"
+
+namespace gen {
+
+static llvm::AtomicOrdering
+convert(AtomicOrdering ordering)
+{
+    switch (ordering) {
+    case RELAXED:
+	return llvm::AtomicOrdering::Monotonic;
+    case ACQUIRE:
+	return llvm::AtomicOrdering::Acquire;
+    case RELEASE:
+	return llvm::AtomicOrdering::Release;
+    case ACQ_REL:
+	return llvm::AtomicOrdering::AcquireRelease;
+    case SEQ_CST:
+	return llvm::AtomicOrdering::SequentiallyConsistent;
+    default:
+	assert(0);
+	return llvm::AtomicOrdering::SequentiallyConsistent;
+    }
+}
+
+// The failure ordering of a cmpxchg can not contain a release part
+static llvm::AtomicOrdering
+failureOrdering(AtomicOrdering ordering)
+{
+    switch (ordering) {
+    case RELEASE:
+	return llvm::AtomicOrdering::Monotonic;
+    case ACQ_REL:
+	return llvm::AtomicOrdering::Acquire;
+    default:
+	return convert(ordering);
+    }
+}
+
+// Atomic accesses require natural alignment, i.e. alignment of at least the
+// size of the accessed object
+static llvm::Align
+naturalAlign(llvm::Type *llvmType)
+{
+    const auto &dataLayout = llvmModule->getDataLayout();
+    return llvm::Align(dataLayout.getTypeStoreSize(llvmType));
+}
+
+Value
+atomicLoad(Value addr, const abc::Type *type, AtomicOrdering ordering)
+{
+    assert(llvmBuilder);
+    assert(type);
+    assert(functionBuildingInfo.fn);
+    reachableCheck();
+
+    auto llvmType = convert(type);
+    auto load =
+        llvmBuilder->CreateAlignedLoad(llvmType, addr, naturalAlign(llvmType));
+    load->setAtomic(convert(ordering));
+    return load;
+}
+
+void
+atomicStore(Value val, Value addr, AtomicOrdering ordering)
+{
+    assert(llvmBuilder);
+    assert(functionBuildingInfo.fn);
+    reachableCheck();
+
+    auto align = naturalAlign(val->getType());
+    auto store = llvmBuilder->CreateAlignedStore(val, addr, align);
+    store->setAtomic(convert(ordering));
+}
+
+Value
+atomicRmw(AtomicRmwOp op, Value addr, Value val, AtomicOrdering ordering)
+{
+    assert(llvmBuilder);
+    assert(functionBuildingInfo.fn);
+    reachableCheck();
+
+    llvm::AtomicRMWInst::BinOp binOp;
+    switch (op) {
+    case ATOMIC_XCHG:
+	binOp = llvm::AtomicRMWInst::Xchg;
+	break;
+    case ATOMIC_ADD:
+	binOp = llvm::AtomicRMWInst::Add;
+	break;
+    case ATOMIC_SUB:
+	binOp = llvm::AtomicRMWInst::Sub;
+	break;
+    case ATOMIC_AND:
+	binOp = llvm::AtomicRMWInst::And;
+	break;
+    case ATOMIC_OR:
+	binOp = llvm::AtomicRMWInst::Or;
+	break;
+    case ATOMIC_XOR:
+	binOp = llvm::AtomicRMWInst::Xor;
+	break;
+    default:
+	assert(0);
+	return nullptr;
+    }
+    auto align = naturalAlign(val->getType());
+    return llvmBuilder->CreateAtomicRMW(binOp, addr, val, align,
+                                        convert(ordering));
+}
+
+std::pair<Value, Value>
+atomicCmpXchg(Value addr, Value expected, Value desired,
+              AtomicOrdering ordering)
+{
+    assert(llvmBuilder);
+    assert(functionBuildingInfo.fn);
+    reachableCheck();
+
+    auto align = naturalAlign(desired->getType());
+    auto cmpXchg = llvmBuilder->CreateAtomicCmpXchg(
+        addr, expected, desired, align, convert(ordering),
+        failureOrdering(ordering));
+    auto old = llvmBuilder->CreateExtractValue(cmpXchg, 0);
+    auto success = llvmBuilder->CreateExtractValue(cmpXchg, 1);
+    return {old, success};
+}
+
+void
+fence(AtomicOrdering ordering)
+{
+    assert(llvmBuilder);
+    assert(functionBuildingInfo.fn);
+    reachableCheck();
+
+    // a relaxed fence is a no-op and not valid IR
+    if (ordering != RELAXED) {
+	llvmBuilder->CreateFence(convert(ordering));
+    }
+}
+
+} // namespace gen
@@ -0,0 +1,44 @@
+#ifndef GEN_ATOMIC_HPP
+#define GEN_ATOMIC_HPP
+
+#include <utility>
+
+#include "type/type.hpp"
+
+#include "gen.hpp"
+
+namespace gen {
+
+// same numbering as the predefined enum constants memory_order_*
+enum AtomicOrdering
+{
+    RELAXED,
+    ACQUIRE,
+    RELEASE,
+    ACQ_REL,
+    SEQ_CST,
+};
+
+enum AtomicRmwOp
+{
+    ATOMIC_XCHG,
+    ATOMIC_ADD,
+    ATOMIC_SUB,
+    ATOMIC_AND,
+    ATOMIC_OR,
+    ATOMIC_XOR,
+};
+
+Value atomicLoad(Value addr, const abc::Type *type, AtomicOrdering ordering);
+void atomicStore(Value val, Value addr, AtomicOrdering ordering);
+Value atomicRmw(AtomicRmwOp op, Value addr, Value val, AtomicOrdering ordering);
+
+// returns the old value and a flag indicating whether the exchange happened
+std::pair<Value, Value> atomicCmpXchg(Value addr, Value expected,
+                                      Value desired, AtomicOrdering ordering);
+
+void fence(AtomicOrdering ordering);
+
+} // namespace gen
+
+#endif // GEN_ATOMIC_HPP
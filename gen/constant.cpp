@@ -72,6 +72,82 @@ getConstantArray(const std::vector<Constant> &val, const abc::Type *arrayType)
     return llvm::ConstantArray::get(llvmArrayType, val);
 }
 
+// Arrays with few initialized elements are represented as an anonymous
+// struct of runs: Initialized elements are grouped into subarrays, larger
+// gaps between them become zeroinitializer subarrays. The struct has the same
+// layout as the array but its size does not depend on the array dimension.
+// Hence the type of the returned constant can differ from the array type.
+Constant
+getConstantArray(const std::map<std::size_t, Constant> &val,
+                 const abc::Type *arrayType)
+{
+    assert(arrayType);
+    assert(arrayType->isArray());
+    auto llvmArrayType = llvm::dyn_cast<llvm::ArrayType>(convert(arrayType));
+    assert(llvmArrayType);
+    auto elementType = llvmArrayType->getElementType();
+    auto dim = llvmArrayType->getNumElements();
+
+    // minimal number of zero elements that get their own subarray
+    constexpr std::size_t minGap = 16;
+
+    std::map<std::size_t, Constant> nonZero;
+    bool sameType = true;
+    for (const auto &[index, c] : val) {
+	assert(index < dim);
+	if (!c->isNullValue()) {
+	    nonZero[index] = c;
+	    sameType = sameType && c->getType() == elementType;
+	}
+    }
+    if (nonZero.empty()) {
+	return llvm::Constant::getNullValue(llvmArrayType);
+    }
+    if (sameType && (dim <= minGap || 2 * nonZero.size() >= dim)) {
+	std::vector<Constant> element(dim,
+	                              llvm::Constant::getNullValue(elementType));
+	for (const auto &[index, c] : nonZero) {
+	    element[index] = c;
+	}
+	return llvm::ConstantArray::get(llvmArrayType, element);
+    }
+
+    std::vector<Constant> field, run;
+    auto flushRun = [&]() {
+	if (!run.empty()) {
+	    auto ty = llvm::ArrayType::get(elementType, run.size());
+	    field.push_back(llvm::ConstantArray::get(ty, run));
+	    run.clear();
+	}
+    };
+    auto addGap = [&](std::size_t gap) {
+	if (gap >= minGap) {
+	    flushRun();
+	    auto ty = llvm::ArrayType::get(elementType, gap);
+	    field.push_back(llvm::Constant::getNullValue(ty));
+	} else {
+	    auto zero = llvm::Constant::getNullValue(elementType);
+	    run.insert(run.end(), gap, zero);
+	}
+    };
+
+    std::size_t pos = 0;
+    for (const auto &[index, c] : nonZero) {
+	addGap(index - pos);
+	if (c->getType() == elementType) {
+	    run.push_back(c);
+	} else {
+	    // e.g. a sparse nested array
+	    flushRun();
+	    field.push_back(c);
+	}
+	pos = index + 1;
+    }
+    addGap(dim - pos);
+    flushRun();
+    return llvm::ConstantStruct::getAnon(field);
+}
+
 Constant
 getConstantStruct(const std::vector<Constant> &val, const abc::Type *structType)
 {
@@ -79,7 +155,26 @@ getConstantStruct(const std::vector<Constant> &val, const abc::Type *structType)
     assert(structType->isStruct());
     auto llvmStructType = llvm::dyn_cast<llvm::StructType>(convert(structType));
     assert(llvmStructType);
-    return llvm::ConstantStruct::get(llvmStructType, val);
+
+    // padding elements are zero initialized
+    std::vector<Constant> element(llvmStructType->getNumElements());
+    for (std::size_t i = 0; i < element.size(); ++i) {
+	element[i] =
+	    llvm::Constant::getNullValue(llvmStructType->getElementType(i));
+    }
+    bool sameType = true;
+    for (std::size_t i = 0; i < val.size(); ++i) {
+	auto index = getElementIndex(llvmStructType, i);
+	element[index] = val[i];
+	sameType = sameType &&
+	           val[i]->getType() == llvmStructType->getElementType(index);
+    }
+    if (!sameType) {
+	// a member is initialized with a sparse array, see getConstantArray()
+	return llvm::ConstantStruct::getAnon(element,
+	                                     llvmStructType->isPacked());
+    }
+    return llvm::ConstantStruct::get(llvmStructType, element);
 }
 
 Constant
@@ -1,6 +1,8 @@
 #ifndef GEN_CONSTANT_HPP
 #define GEN_CONSTANT_HPP
 
+#include <map>
+
 #include "gen.hpp"
 #include "type/type.hpp"
 
@@ -15,6 +17,8 @@ ConstantFloat getConstantFloat(double val, const abc::Type *type);
 
 Constant getConstantArray(const std::vector<Constant> &val,
                           const abc::Type *arrayType);
+Constant getConstantArray(const std::map<std::size_t, Constant> &val,
+                          const abc::Type *arrayType);
 Constant getConstantStruct(const std::vector<Constant> &val,
                            const abc::Type *structType);
 
@@ -0,0 +1,126 @@
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+#include "llvm/BinaryFormat/Dwarf.h"
+#include "llvm/IR/DIBuilder.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+
+#include "debuginfo.hpp"
+#include "function.hpp"
+#include "remark.hpp"
+
+namespace gen {
+
+static std::unique_ptr<llvm::DIBuilder> diBuilder;
+static llvm::DICompileUnit *compileUnit;
+static std::unordered_map<std::string, llvm::DIFile *> diFile;
+
+// subprogram of the current function and its scopes for locations in other
+// files, e.g. in macros expanded from a header
+static llvm::DISubprogram *subprogram;
+static std::unordered_map<llvm::DIFile *, llvm::DIScope *> fileScope;
+
+static llvm::DIFile *
+getFile(const char *path)
+{
+    auto found = diFile.find(path);
+    if (found != diFile.end()) {
+	return found->second;
+    }
+    auto dir = std::filesystem::current_path().string();
+    return diFile[path] = diBuilder->createFile(path, dir);
+}
+
+void
+initDebugInfo(const char *path)
+{
+    assert(llvmModule);
+    diBuilder.reset();
+    diFile.clear();
+    compileUnit = nullptr;
+    subprogram = nullptr;
+    if (!opt::debugInfo && !remarksEnabled()) {
+	return;
+    }
+
+    diBuilder = std::make_unique<llvm::DIBuilder>(*llvmModule);
+    bool isOptimized = getOptimizationLevel() != llvm::OptimizationLevel::O0;
+    auto emissionKind = opt::debugInfo ? llvm::DICompileUnit::LineTablesOnly
+                                       : llvm::DICompileUnit::NoDebug;
+    compileUnit = diBuilder->createCompileUnit(llvm::dwarf::DW_LANG_C,
+                                               getFile(path), "abc",
+                                               isOptimized, "", 0, "",
+                                               emissionKind);
+
+    llvmModule->addModuleFlag(llvm::Module::Warning, "Dwarf Version", 5);
+    llvmModule->addModuleFlag(llvm::Module::Warning, "Debug Info Version",
+                              llvm::DEBUG_METADATA_VERSION);
+}
+
+void
+finalizeDebugInfo()
+{
+    if (diBuilder) {
+	diBuilder->finalize();
+    }
+}
+
+void
+debugInfoFunctionBegin(const char *path, std::size_t line)
+{
+    if (!diBuilder) {
+	return;
+    }
+    auto fn = functionBuildingInfo.fn;
+    assert(fn);
+    assert(llvmBuilder);
+
+    auto file = getFile(path);
+    auto fnType =
+        diBuilder->createSubroutineType(diBuilder->getOrCreateTypeArray({}));
+    auto spFlags = llvm::DISubprogram::SPFlagDefinition;
+    if (compileUnit->isOptimized()) {
+	spFlags |= llvm::DISubprogram::SPFlagOptimized;
+    }
+    if (fn->hasLocalLinkage()) {
+	spFlags |= llvm::DISubprogram::SPFlagLocalToUnit;
+    }
+    subprogram = diBuilder->createFunction(
+        file, fn->getName(), fn->getName(), file, line, fnType, line,
+        llvm::DINode::FlagPrototyped, spFlags);
+    fn->setSubprogram(subprogram);
+    fileScope.clear();
+    fileScope[file] = subprogram;
+
+    llvmBuilder->SetCurrentDebugLocation(
+        llvm::DILocation::get(*llvmContext, line, 0, subprogram));
+}
+
+void
+debugInfoFunctionEnd()
+{
+    if (!diBuilder || !subprogram) {
+	return;
+    }
+    diBuilder->finalizeSubprogram(subprogram);
+    subprogram = nullptr;
+    llvmBuilder->SetCurrentDebugLocation(llvm::DebugLoc());
+}
+
+void
+debugLocation(const char *path, std::size_t line, std::size_t col)
+{
+    if (!subprogram || !path || !*path) {
+	return;
+    }
+    auto file = getFile(path);
+    auto &scope = fileScope[file];
+    if (!scope) {
+	scope = diBuilder->createLexicalBlockFile(subprogram, file);
+    }
+    llvmBuilder->SetCurrentDebugLocation(
+        llvm::DILocation::get(*llvmContext, line, col, scope));
+}
+
+} // namespace gen
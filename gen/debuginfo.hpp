@@ -0,0 +1,28 @@
+#ifndef GEN_DEBUGINFO_HPP
+#define GEN_DEBUGINFO_HPP
+
+#include <cstddef>
+
+#include "gen.hpp"
+
+namespace gen {
+
+// Debug information (DWARF line tables) for source file 'path'. All functions
+// do nothing unless enabled by opt::debugInfo. Optimization remarks only track
+// source locations without emitting debug information, see remarksEnabled().
+void initDebugInfo(const char *path);
+void finalizeDebugInfo();
+
+// Attaches a subprogram to the function being defined, see
+// functionDefinitionBegin(). Its definition starts in 'line' of 'path', which
+// also becomes the current debug location. The subprogram gets completed by
+// functionDefinitionEnd().
+void debugInfoFunctionBegin(const char *path, std::size_t line);
+void debugInfoFunctionEnd();
+
+// Instructions created afterwards get this source location
+void debugLocation(const char *path, std::size_t line, std::size_t col);
+
+} // namespace gen
+
+#endif // GEN_DEBUGINFO_HPP
@@ -8,7 +8,9 @@
 #include "llvm/IR/Verifier.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
 
+#include "abi.hpp"
 #include "constant.hpp"
+#include "debuginfo.hpp"
 #include "function.hpp"
 #include "gen.hpp"
 #include "gentype.hpp"
@@ -33,6 +35,10 @@ functionDeclaration(const char *ident, const abc::Type *fnType,
                     bool externalLinkage)
 {
     assert(llvmContext);
+    if (llvmModule->getNamedIFunc(ident)) {
+	// defined with target clones, calls go through the ifunc
+	return nullptr;
+    }
     if (auto fn = llvmModule->getFunction(ident)) {
 	// already declared
 	/*
@@ -55,6 +61,8 @@ functionDeclaration(const char *ident, const abc::Type *fnType,
 
     auto fn =
         llvm::Function::Create(llvmFnType, linkage, ident, llvmModule.get());
+
+    setAttributes(fn, fnType);
     return fn;
 }
 
@@ -67,7 +75,18 @@ functionDefinitionBegin(const char *ident, const abc::Type *fnType,
 
     forgetAllLocalVariables();
     auto fn = functionDeclaration(ident, fnType, externalLinkage);
+    assert(fn);
     fn->setDoesNotThrow();
+    // code is generated for the selected CPU also by a later optimization
+    // or LTO step that uses a different target machine
+    fn->addFnAttr("target-cpu", targetMachine->getTargetCPU());
+    auto features = targetMachine->getTargetFeatureString();
+    if (!features.empty()) {
+	fn->addFnAttr("target-features", features);
+    }
+    if (opt::framePointer) {
+	fn->addFnAttr("frame-pointer", "all");
+    }
     llvmBB = llvm::BasicBlock::Create(*llvmContext, "entry", fn);
     llvmBuilder->SetInsertPoint(llvmBB);
 
@@ -80,18 +99,37 @@ functionDefinitionBegin(const char *ident, const abc::Type *fnType,
     }
 
     functionBuildingInfo.fn = fn;
+    functionBuildingInfo.fnType = fnType;
     functionBuildingInfo.leave = getLabel(".leave");
     functionBuildingInfo.retType = retType;
     functionBuildingInfo.retVal = nullptr;
     functionBuildingInfo.bbClosed = false;
 
+    const auto &info = getFunctionInfo(fnType);
+    if (info.ret.kind == ArgInfo::SRET) {
+	functionBuildingInfo.retVal = fn->getArg(0);
+    }
+
     for (std::size_t i = 0; i < param.size(); ++i) {
 	// std::cerr << ">> i = " << i << "\n";
-	auto addr = localVariableDefinition(param[i], fnType->paramType()[i]);
-	store(fn->getArg(i), addr);
+	auto paramType = fnType->paramType()[i];
+	auto arg = fn->getArg(i + info.argOffset);
+	if (info.param[i].kind == ArgInfo::INDIRECT ||
+	    info.param[i].kind == ArgInfo::BYVAL) {
+	    // the copy made by the caller or the call is used as local
+	    // variable
+	    localVariableReference(param[i], arg);
+	    continue;
+	}
+	auto addr = localVariableDefinition(param[i], paramType);
+	if (info.param[i].kind == ArgInfo::COERCE) {
+	    storeCoerced(arg, addr, paramType);
+	} else {
+	    store(arg, addr);
+	}
     }
 
-    if (!retType->isVoid()) {
+    if (!retType->isVoid() && !functionBuildingInfo.retVal) {
 	functionBuildingInfo.retVal =
 	    localVariableDefinition(".retVal", retType);
 	if (functionBuildingInfo.isMain) {
@@ -138,7 +176,7 @@ functionDefinitionEnd()
     defineLabel(checkReturn);
     if (checkReturn->hasNPredecessorsOrMore(1)) {
 	wellFormed = functionBuildingInfo.isMain ||
-	             functionBuildingInfo.fn->getReturnType()->isVoidTy();
+	             functionBuildingInfo.retType->isVoid();
 	if (!wellFormed) {
 	    llvmBuilder->CreateUnreachable();
 	}
@@ -147,8 +185,14 @@ functionDefinitionEnd()
     llvm::EliminateUnreachableBlocks(*functionBuildingInfo.fn);
 
     defineLabel(functionBuildingInfo.leave);
-    if (functionBuildingInfo.retType->isVoid()) {
+    const auto &ret = getFunctionInfo(functionBuildingInfo.fnType).ret;
+    if (functionBuildingInfo.retType->isVoid() || ret.kind == ArgInfo::SRET) {
+	// also if the value was stored in the return slot
 	llvmBuilder->CreateRetVoid();
+    } else if (ret.kind == ArgInfo::COERCE) {
+	auto retVal = loadCoerced(functionBuildingInfo.retVal,
+	                          functionBuildingInfo.retType, ret.coerceType);
+	llvmBuilder->CreateRet(retVal);
     } else {
 	auto retVal =
 	    fetch(functionBuildingInfo.retVal, functionBuildingInfo.retType);
@@ -156,24 +200,145 @@ functionDefinitionEnd()
     }
 
     llvm::verifyFunction(*functionBuildingInfo.fn);
+    debugInfoFunctionEnd();
 
     functionBuildingInfo.fn = nullptr;
+    functionBuildingInfo.fnType = nullptr;
     functionBuildingInfo.leave = nullptr;
     functionBuildingInfo.retType = nullptr;
     functionBuildingInfo.retVal = nullptr;
     functionBuildingInfo.bbClosed = true;
     functionBuildingInfo.isMain = false;
+    functionBuildingInfo.label.clear();
+    functionBuildingInfo.addressTaken.clear();
+    functionBuildingInfo.indirectJump.clear();
+    functionBuildingInfo.rangeChecks.clear();
     return wellFormed;
 }
 
+bool
+hasReturnSlot(const abc::Type *fnType)
+{
+    return getFunctionInfo(fnType).ret.kind == ArgInfo::SRET;
+}
+
+Value
+returnValueAddress()
+{
+    assert(functionBuildingInfo.fn);
+    assert(functionBuildingInfo.retVal);
+    return functionBuildingInfo.retVal;
+}
+
+static llvm::CallInst *
+createCall(Value fnAddr, const abc::Type *fnType,
+           const std::vector<Value> &arg, Value retAddr)
+{
+    const auto &info = getFunctionInfo(fnType);
+    const auto &paramType = fnType->paramType();
+
+    std::vector<Value> llvmArg;
+    if (info.ret.kind == ArgInfo::SRET) {
+	assert(retAddr);
+	llvmArg.push_back(retAddr);
+    }
+    for (std::size_t i = 0; i < arg.size(); ++i) {
+	if (i >= paramType.size()) {
+	    // variable argument
+	    llvmArg.push_back(arg[i]);
+	    continue;
+	}
+	switch (info.param[i].kind) {
+	case ArgInfo::COERCE:
+	    llvmArg.push_back(
+	        loadCoerced(arg[i], paramType[i], info.param[i].coerceType));
+	    break;
+	case ArgInfo::INDIRECT:
+	case ArgInfo::BYVAL:
+	    llvmArg.push_back(arg[i]);
+	    break;
+	default:
+	    llvmArg.push_back(paramType[i]->isScalar()
+	                          ? arg[i]
+	                          : fetch(arg[i], paramType[i]));
+	    break;
+	}
+    }
+    auto call = llvmBuilder->CreateCall(info.llvmFnType, fnAddr, llvmArg);
+    setAttributes(call, fnType);
+    return call;
+}
+
+// Arguments of aggregate type are passed as address of a copy that can be
+// used by the call. If 'retAddr' is given the return value is stored there,
+// for an aggregate return value it is required.
 Value
 functionCall(Value fnAddr, const abc::Type *fnType,
-             const std::vector<Value> &arg)
+             const std::vector<Value> &arg, Value retAddr)
 {
     assert(fnType);
-    auto llvmFnType = llvm::dyn_cast<llvm::FunctionType>(convert(fnType));
-    assert(llvmFnType);
-    return llvmBuilder->CreateCall(llvmFnType, fnAddr, arg);
+    const auto &info = getFunctionInfo(fnType);
+    auto call = createCall(fnAddr, fnType, arg, retAddr);
+
+    auto retType = fnType->retType();
+    if (info.ret.kind == ArgInfo::SRET) {
+	return call;
+    } else if (info.ret.kind == ArgInfo::COERCE) {
+	assert(retAddr);
+	storeCoerced(call, retAddr, retType);
+    } else if (retAddr) {
+	store(call, retAddr);
+    }
+    return call;
+}
+
+const char *
+tailCallMismatch(const abc::Type *fnType)
+{
+    assert(fnType);
+    assert(functionBuildingInfo.fnType);
+    auto callerType = functionBuildingInfo.fnType;
+
+    if (fnType->hasVarg() || callerType->hasVarg()) {
+	return "variadic functions are not supported";
+    }
+    const auto &info = getFunctionInfo(fnType);
+    const auto &callerInfo = getFunctionInfo(callerType);
+    if (info.llvmFnType != callerInfo.llvmFnType ||
+        info.ret != callerInfo.ret || info.param != callerInfo.param) {
+	return "signature is not compatible with the calling function";
+    }
+    if (info.ret.kind == ArgInfo::SRET &&
+        convert(fnType->retType()) != convert(callerType->retType())) {
+	return "return type is not compatible with the calling function";
+    }
+    for (const auto &param : info.param) {
+	// the copy would be a local of the calling function
+	if (param.kind == ArgInfo::INDIRECT || param.kind == ArgInfo::BYVAL) {
+	    return "arguments passed in memory are not supported";
+	}
+    }
+    return nullptr;
+}
+
+void
+tailCall(Value fnAddr, const abc::Type *fnType, const std::vector<Value> &arg)
+{
+    assert(llvmBuilder);
+    assert(functionBuildingInfo.fn);
+    assert(!tailCallMismatch(fnType));
+    reachableCheck();
+
+    // a return slot is passed through
+    auto retAddr = hasReturnSlot(fnType) ? returnValueAddress() : nullptr;
+    auto call = createCall(fnAddr, fnType, arg, retAddr);
+    call->setTailCallKind(llvm::CallInst::TCK_MustTail);
+    if (call->getType()->isVoidTy()) {
+	llvmBuilder->CreateRetVoid();
+    } else {
+	llvmBuilder->CreateRet(call);
+    }
+    functionBuildingInfo.bbClosed = true;
 }
 
 } // namespace gen
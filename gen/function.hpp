@@ -6,7 +6,11 @@
 #include "llvm/Support/Solaris/sys/regset.h"
 #endif // SUPPORT_SOLARIS
 
+#include <unordered_map>
+#include <vector>
+
 #include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
 
 #include "type/type.hpp"
 
@@ -17,11 +21,19 @@ namespace gen {
 struct FunctionBuildingInfo
 {
 	llvm::Function *fn = nullptr;
+	const abc::Type *fnType = nullptr;
 	Label leave = nullptr;
 	const abc::Type *retType = nullptr;
 	Value retVal = nullptr;
 	bool bbClosed = true;
 	bool isMain = false;
+	// labels by name and labels that are targets of indirect jumps, see
+	// labelAddress() and indirectJumpInstruction()
+	std::unordered_map<const char *, Label> label;
+	std::vector<Label> addressTaken;
+	std::vector<llvm::IndirectBrInst *> indirectJump;
+	// number of range checks following a switch, see switchLowering()
+	std::unordered_map<JumpOrigin, std::size_t> rangeChecks;
 };
 
 extern FunctionBuildingInfo functionBuildingInfo;
@@ -30,6 +42,8 @@ extern FunctionBuildingInfo functionBuildingInfo;
 // not reachable
 bool bbOpen();
 
+// Returns a null pointer if 'ident' already names the ifunc of a function with
+// target clones, see targetClones()
 llvm::Function *functionDeclaration(const char *ident, const abc::Type *fnType,
                                     bool externalLinkage);
 
@@ -39,8 +53,23 @@ void functionDefinitionBegin(const char *ident, const abc::Type *fnType,
 
 bool functionDefinitionEnd();
 
+// Some aggregates are returned in a slot provided by the caller, see
+// getFunctionInfo(). Then the call has no value.
+bool hasReturnSlot(const abc::Type *fnType);
+Value returnValueAddress();
+
 Value functionCall(Value fnAddr, const abc::Type *fnType,
-                   const std::vector<Value> &arg);
+                   const std::vector<Value> &arg, Value retAddr = nullptr);
+
+// A guaranteed tail call requires that the current function and 'fnType' pass
+// arguments and return values in the same way. Returns nullptr if this is the
+// case, otherwise a description of the mismatch.
+const char *tailCallMismatch(const abc::Type *fnType);
+
+// Emits a call marked as 'musttail' followed by a return of its result. The
+// current basic block gets closed.
+void tailCall(Value fnAddr, const abc::Type *fnType,
+              const std::vector<Value> &arg);
 
 } // namespace gen
 
@@ -7,9 +7,11 @@
 #include "llvm/Support/CodeGen.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/TargetParser/Host.h"
+#include "llvm/TargetParser/SubtargetFeature.h"
 #include "llvm/Transforms/Scalar/GVN.h"
 #include "llvm/Transforms/Scalar/Reassociate.h"
 
+#include "abi.hpp"
 #include "gen.hpp"
 #include "gentype.hpp"
 #include "variable.hpp"
@@ -21,11 +23,26 @@ std::unique_ptr<llvm::Module> llvmModule;
 std::unique_ptr<llvm::IRBuilder<>> llvmBuilder;
 llvm::BasicBlock *llvmBB;
 llvm::TargetMachine *targetMachine;
+std::recursive_mutex llvmContextMutex;
 
 namespace opt {
 
 std::string target;
 std::string mcu;
+std::string mcpu;
+std::string mattr;
+bool reportSwitch;
+bool debugInfo;
+bool framePointer;
+std::string remarkPass;
+std::string remarkMissed;
+std::string remarkAnalysis;
+std::string optRecordFormat;
+std::string passPipeline;
+std::vector<std::pair<std::string, std::string>> extensionPointPasses;
+std::vector<std::string> passPlugin;
+unsigned parallelCodegen = 1;
+std::string incrementalCache;
 
 } // namespace opt
 
@@ -92,6 +109,10 @@ getCpu()
 {
     using namespace opt;
 
+    if (mcpu == "native")
+	return llvm::sys::getHostCPUName().str();
+    if (!mcpu.empty())
+	return mcpu;
     if (opt::mcu.empty())
 	return "generic";
 
@@ -107,7 +128,21 @@ getCpu()
 static std::string
 getFeatures()
 {
-    return "";
+    using namespace opt;
+
+    llvm::SubtargetFeatures features;
+    if (mcpu == "native") {
+	for (const auto &feature : llvm::sys::getHostCPUFeatures()) {
+	    features.AddFeature(feature.getKey(), feature.getValue());
+	}
+    }
+    // explicit features, e.g. "+avx2,-fma", override those of the host
+    llvm::SmallVector<llvm::StringRef> attr;
+    llvm::StringRef{mattr}.split(attr, ',', -1, false);
+    for (auto a : attr) {
+	features.AddFeature(a);
+    }
+    return features.getString();
 }
 
 static llvm::Reloc::Model
@@ -124,6 +159,7 @@ init(const char *name, llvm::OptimizationLevel optLevel)
     optimizationLevel = optLevel;
     forgetAllVariables();
     initTypeMap();
+    initFunctionInfo();
     moduleName = name ? name : "llvm";
 
     if (!llvmContext) {
@@ -155,6 +191,15 @@ init(const char *name, llvm::OptimizationLevel optLevel)
     auto codeModel = std::optional<llvm::CodeModel::Model>();
     llvm::CodeGenOptLevel cgOpt = mapOpt(optLevel);
 
+    // the name and features of the host CPU are meaningless for another
+    // architecture
+    llvm::Triple hostTT{llvm::sys::getProcessTriple()};
+    if (opt::mcpu == "native" && TT.getArch() != hostTT.getArch()) {
+	llvm::errs() << "warning: host CPU does not match target '"
+	             << tripleStr << "', ignoring -mcpu=native\n";
+	opt::mcpu.clear();
+    }
+
     auto cpu = getCpu();
     targetMachine = target->createTargetMachine(TT, cpu, getFeatures(), topts,
                                                 relocModel, codeModel, cgOpt);
@@ -1,7 +1,10 @@
 #ifndef GEN_GEN_HPP
 #define GEN_GEN_HPP
 
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #ifdef SUPPORT_SOLARIS
 // has to be included as first llvm header
@@ -31,11 +34,40 @@ extern std::unique_ptr<llvm::Module> llvmModule;
 extern std::unique_ptr<llvm::IRBuilder<>> llvmBuilder;
 extern llvm::BasicBlock *llvmBB;
 extern llvm::TargetMachine *targetMachine;
+// Guards the LLVM context if the parser evaluates constant expressions while
+// code for earlier declarations is generated by another thread
+extern std::recursive_mutex llvmContextMutex;
 
 namespace opt {
 
 extern std::string target;
 extern std::string mcu;
+// CPU and target features, "native" selects the host CPU and its features
+extern std::string mcpu;
+extern std::string mattr;
+// report how switch statements are lowered, see switchLowering()
+extern bool reportSwitch;
+// emit DWARF line tables, see initDebugInfo()
+extern bool debugInfo;
+// keep the frame pointer in all functions for stack unwinding by profilers
+extern bool framePointer;
+// regular expressions for pass names of reported optimization remarks, and
+// "yaml" or "bitstream" for saving all remarks, see beginRemarks()
+extern std::string remarkPass;
+extern std::string remarkMissed;
+extern std::string remarkAnalysis;
+extern std::string optRecordFormat;
+// textual pass pipeline replacing the default one, passes inserted at
+// extension points of the default pipeline, and pass plugins, see
+// registerPassCallbacks()
+extern std::string passPipeline;
+extern std::vector<std::pair<std::string, std::string>> extensionPointPasses;
+extern std::vector<std::string> passPlugin;
+// number of threads generating an object file, see print()
+extern unsigned parallelCodegen;
+// directory caching the optimized IR of each function between compilations,
+// see loadCachedFunctions()
+extern std::string incrementalCache;
 
 } // namespace opt
 
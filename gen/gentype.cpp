@@ -1,8 +1,11 @@
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "abi.hpp"
 #include "gen.hpp"
 #include "gentype.hpp"
 
@@ -17,13 +20,19 @@ namespace gen {
 
 static std::unordered_map<const abc::Type *, llvm::Type *> typeMap;
 
-static std::vector<llvm::Type *>
-convert(const std::vector<const abc::Type *> &type);
+// For structs with an explicit layout: alignment and the LLVM element index
+// of each member index
+static std::unordered_map<llvm::Type *, llvm::Align> alignMap;
+static std::unordered_map<llvm::Type *, std::vector<unsigned>> elementIndexMap;
+
+static llvm::Type *convertStruct(const abc::Type *abcType);
 
 void
 initTypeMap()
 {
     typeMap.clear();
+    alignMap.clear();
+    elementIndexMap.clear();
 }
 
 llvm::Type *
@@ -63,30 +72,22 @@ convert(const abc::Type *abcType)
 	    break;
 	}
     } else if (abcType->isFunction()) {
-	llvmType = llvm::FunctionType::get(convert(abcType->retType()),
-	                                   convert(abcType->paramType()),
-	                                   abcType->hasVarg());
+	// parameters and return value are lowered according to the C ABI
+	llvmType = getFunctionInfo(abcType).llvmFnType;
     } else if (abcType->isPointer()) {
 	llvmType = llvm::PointerType::get(*llvmContext, 0);
     } else if (abcType->isArray()) {
 	llvmType =
 	    llvm::ArrayType::get(convert(abcType->refType()), abcType->dim());
     } else if (abcType->isStruct()) {
-	auto abcMemberType = abcType->memberType();
-	auto abcMemberIndex = abcType->memberIndex();
-	auto lastIndex = abcMemberIndex.back();
-	std::vector<llvm::Type *> llvmMemberType{lastIndex + 1};
-	for (std::size_t i = 0, pos = 0; i <= lastIndex; ++i) {
-	    std::size_t maxSize = 0;
-	    while (pos < abcMemberIndex.size() && abcMemberIndex[pos] == i) {
-		if (getSizeof(abcMemberType[pos]) > maxSize) {
-		    maxSize = getSizeof(abcMemberType[pos]);
-		    llvmMemberType[i] = convert(abcMemberType[pos]);
-		}
-		++pos;
-	    }
+	// const and aliased struct types share the LLVM type
+	auto structType = abcType->isAlias() ? abcType->getUnalias() : abcType;
+	structType = structType->getConstRemoved();
+	if (structType != abcType) {
+	    llvmType = convert(structType);
+	} else {
+	    llvmType = convertStruct(abcType);
 	}
-	llvmType = llvm::StructType::get(*llvmContext, llvmMemberType);
     } else {
 	std::cerr << "gen::convert with type '" << abcType << "'\n";
 	assert(0);
@@ -96,13 +97,67 @@ convert(const abc::Type *abcType)
     return llvmType;
 }
 
-static std::vector<llvm::Type *>
-convert(const std::vector<const abc::Type *> &abcType)
+static void
+appendPadding(std::vector<llvm::Type *> &element, std::uint64_t size)
 {
-    std::vector<llvm::Type *> llvmType{abcType.size()};
-    for (std::size_t i = 0; i < abcType.size(); ++i) {
-	llvmType[i] = convert(abcType[i]);
+    if (size) {
+	auto i8Type = llvm::Type::getInt8Ty(*llvmContext);
+	element.push_back(llvm::ArrayType::get(i8Type, size));
     }
+}
+
+static llvm::Type *
+convertStruct(const abc::Type *abcType)
+{
+    auto abcMemberType = abcType->memberType();
+    auto abcMemberIndex = abcType->memberIndex();
+    auto lastIndex = abcMemberIndex.back();
+    std::vector<llvm::Type *> llvmMemberType{lastIndex + 1};
+    std::vector<llvm::Align> memberAlign{lastIndex + 1};
+    bool explicitLayout = abcType->isPacked() || abcType->alignment();
+    for (std::size_t i = 0, pos = 0; i <= lastIndex; ++i) {
+	std::size_t maxSize = 0;
+	while (pos < abcMemberIndex.size() && abcMemberIndex[pos] == i) {
+	    auto ty = convert(abcMemberType[pos]);
+	    if (getSizeof(abcMemberType[pos]) > maxSize) {
+		maxSize = getSizeof(abcMemberType[pos]);
+		llvmMemberType[i] = ty;
+	    }
+	    memberAlign[i] = std::max(memberAlign[i], getAlignment(ty));
+	    ++pos;
+	}
+	auto &dl = llvmModule->getDataLayout();
+	if (memberAlign[i] != dl.getABITypeAlign(llvmMemberType[i])) {
+	    explicitLayout = true;
+	}
+    }
+    if (!explicitLayout) {
+	return llvm::StructType::get(*llvmContext, llvmMemberType);
+    }
+
+    // The layout is computed here and the LLVM type is a packed struct where
+    // the padding is explicit
+    auto &dl = llvmModule->getDataLayout();
+    std::vector<llvm::Type *> element;
+    std::vector<unsigned> elementIndex;
+    llvm::Align structAlign{std::max<std::size_t>(abcType->alignment(), 1)};
+    std::uint64_t offset = 0;
+    for (std::size_t i = 0; i <= lastIndex; ++i) {
+	auto align = abcType->isPacked() ? llvm::Align(1) : memberAlign[i];
+	structAlign = std::max(structAlign, align);
+	appendPadding(element, llvm::alignTo(offset, align) - offset);
+	offset = llvm::alignTo(offset, align);
+	elementIndex.push_back(element.size());
+	element.push_back(llvmMemberType[i]);
+	offset += dl.getTypeAllocSize(llvmMemberType[i]);
+    }
+    appendPadding(element, llvm::alignTo(offset, structAlign) - offset);
+
+    auto name = std::string{"struct."} + abcType->ustr().c_str();
+    auto llvmType = llvm::StructType::create(*llvmContext, element, name,
+                                             /*isPacked=*/true);
+    alignMap[llvmType] = structAlign;
+    elementIndexMap[llvmType] = std::move(elementIndex);
     return llvmType;
 }
 
@@ -114,4 +169,40 @@ getSizeof(const abc::Type *type)
     return llvmModule->getDataLayout().getTypeAllocSize(llvmType);
 }
 
+std::size_t
+getAlignof(const abc::Type *type)
+{
+    assert(llvmContext && "gen::init called?");
+    return getAlignment(convert(type)).value();
+}
+
+bool
+isLargeAggregate(const abc::Type *type)
+{
+    // larger than what fits into two registers on 64-bit targets
+    constexpr std::size_t maxSize = 16;
+    return !type->isScalar() && type->hasSize() && getSizeof(type) > maxSize;
+}
+
+llvm::Align
+getAlignment(llvm::Type *llvmType)
+{
+    if (alignMap.contains(llvmType)) {
+	return alignMap.at(llvmType);
+    } else if (auto arrayType = llvm::dyn_cast<llvm::ArrayType>(llvmType)) {
+	return getAlignment(arrayType->getElementType());
+    }
+    return llvmModule->getDataLayout().getABITypeAlign(llvmType);
+}
+
+unsigned
+getElementIndex(llvm::Type *llvmStructType, std::size_t index)
+{
+    assert(llvmStructType->isStructTy());
+    if (elementIndexMap.contains(llvmStructType)) {
+	return elementIndexMap.at(llvmStructType).at(index);
+    }
+    return index;
+}
+
 } // namespace gen
@@ -7,6 +7,7 @@
 #endif // SUPPORT_SOLARIS
 
 #include "llvm/IR/Type.h"
+#include "llvm/Support/Alignment.h"
 
 #include "type/type.hpp"
 
@@ -15,6 +16,18 @@ namespace gen {
 void initTypeMap();
 llvm::Type *convert(const abc::Type *type);
 std::size_t getSizeof(const abc::Type *type);
+std::size_t getAlignof(const abc::Type *type);
+
+// Large aggregates are copied with memcpy instead of loads and stores
+bool isLargeAggregate(const abc::Type *type);
+
+// Alignment of a type in memory. For structs declared with 'packed' or
+// 'alignas' this differs from the ABI alignment of the LLVM type.
+llvm::Align getAlignment(llvm::Type *llvmType);
+
+// LLVM element index of the struct member with the given index. Differs from
+// the index if padding elements were inserted.
+unsigned getElementIndex(llvm::Type *llvmStructType, std::size_t index);
 
 } // namespace gen
 
@@ -0,0 +1,567 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Analysis/LazyCallGraph.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+
+#include "incremental.hpp"
+
+namespace gen {
+
+struct Fresh
+{
+	std::string name;
+	std::string key;
+	bool localLinkage;
+};
+
+// Functions replaced by cached code, and the cache keys of the others
+static llvm::StringSet<> cached;
+static std::vector<Fresh> fresh;
+
+// Value type and initializer of the local globals before optimization
+struct LocalGlobal
+{
+	llvm::Type *type;
+	const llvm::Constant *init;
+};
+
+static llvm::StringMap<LocalGlobal> localGlobal;
+
+static std::string
+md5(llvm::StringRef text)
+{
+    llvm::MD5 hash;
+    hash.update(text);
+    llvm::MD5::MD5Result result;
+    hash.final(result);
+    return result.digest().str().str();
+}
+
+// Entries that were not used for the longest time are removed when the cache
+// grows beyond this size
+static constexpr std::uintmax_t cacheSizeLimit = std::uintmax_t{256} << 20;
+
+static std::filesystem::path
+entryPath(const std::string &key)
+{
+    return std::filesystem::path{opt::incrementalCache} / (key + ".bc");
+}
+
+// Everything besides the IR that determines the optimized code
+static std::string
+optimizationSettings()
+{
+    std::string settings;
+    llvm::raw_string_ostream os{settings};
+    auto level = getOptimizationLevel();
+    os << LLVM_VERSION_STRING << " O" << level.getSpeedupLevel() << " s"
+       << level.getSizeLevel() << " " << targetMachine->getTargetCPU() << " "
+       << targetMachine->getTargetFeatureString() << " " << opt::passPipeline;
+    for (const auto &[ep, text] : opt::extensionPointPasses) {
+	os << " " << ep << "=" << text;
+    }
+    for (const auto &plugin : opt::passPlugin) {
+	os << " " << plugin;
+    }
+    return os.str();
+}
+
+// Globals referenced by the code of 'fn', also through the initializers of
+// private constants, in order of their first use
+static std::vector<llvm::GlobalValue *>
+referencedGlobals(llvm::Function *fn)
+{
+    std::vector<llvm::GlobalValue *> ref;
+    std::unordered_set<const llvm::Value *> visited{fn};
+
+    std::function<void(llvm::Value *)> visit = [&](llvm::Value *val) {
+	auto c = llvm::dyn_cast<llvm::Constant>(val);
+	if (!c || !visited.insert(c).second) {
+	    return;
+	}
+	if (auto gv = llvm::dyn_cast<llvm::GlobalValue>(c)) {
+	    ref.push_back(gv);
+	    auto var = llvm::dyn_cast<llvm::GlobalVariable>(gv);
+	    if (var && var->hasPrivateLinkage() && var->hasInitializer()) {
+		visit(var->getInitializer());
+	    }
+	    return;
+	}
+	for (auto &op : c->operands()) {
+	    visit(op);
+	}
+    };
+
+    if (fn->hasPersonalityFn()) {
+	visit(fn->getPersonalityFn());
+    }
+    for (auto &bb : *fn) {
+	for (auto &inst : bb) {
+	    for (auto &op : inst.operands()) {
+		visit(op);
+	    }
+	}
+    }
+    return ref;
+}
+
+// Returns a module with a copy of 'fn' and declarations of the globals 'ref'
+// it refers to. Private constants like string literals are copied and named
+// by their order of use, so the module does not depend on other functions.
+static std::unique_ptr<llvm::Module>
+extractFunction(llvm::Function *fn, const std::vector<llvm::GlobalValue *> &ref)
+{
+    auto m = std::make_unique<llvm::Module>(fn->getName(), *llvmContext);
+    m->setDataLayout(llvmModule->getDataLayout());
+    m->setTargetTriple(llvmModule->getTargetTriple());
+
+    llvm::ValueToValueMapTy vmap;
+    auto newFn =
+        llvm::Function::Create(fn->getFunctionType(),
+                               llvm::GlobalValue::ExternalLinkage,
+                               fn->getName(), *m);
+    newFn->copyAttributesFrom(fn);
+    vmap[fn] = newFn;
+    auto newArg = newFn->arg_begin();
+    for (auto &arg : fn->args()) {
+	newArg->setName(arg.getName());
+	vmap[&arg] = &*newArg++;
+    }
+
+    std::vector<llvm::GlobalVariable *> privateVar;
+    for (auto gv : ref) {
+	auto var = llvm::dyn_cast<llvm::GlobalVariable>(gv);
+	if (var && var->hasPrivateLinkage()) {
+	    auto copy = new llvm::GlobalVariable(
+	        *m, var->getValueType(), var->isConstant(),
+	        var->getLinkage(), nullptr,
+	        ".C" + std::to_string(privateVar.size()));
+	    copy->copyAttributesFrom(var);
+	    privateVar.push_back(var);
+	    vmap[var] = copy;
+	} else if (auto fnType =
+	               llvm::dyn_cast<llvm::FunctionType>(gv->getValueType())) {
+	    auto decl = llvm::Function::Create(
+	        fnType, llvm::GlobalValue::ExternalLinkage, gv->getName(), *m);
+	    if (auto callee = llvm::dyn_cast<llvm::Function>(gv)) {
+		decl->copyAttributesFrom(callee);
+	    }
+	    vmap[gv] = decl;
+	} else {
+	    vmap[gv] = new llvm::GlobalVariable(
+	        *m, gv->getValueType(), var && var->isConstant(),
+	        llvm::GlobalValue::ExternalLinkage, nullptr, gv->getName(),
+	        nullptr, gv->getThreadLocalMode(), gv->getAddressSpace());
+	}
+    }
+    for (auto var : privateVar) {
+	auto copy = llvm::cast<llvm::GlobalVariable>(vmap[var]);
+	copy->setInitializer(llvm::MapValue(var->getInitializer(), vmap));
+    }
+
+    llvm::SmallVector<llvm::ReturnInst *> returns;
+    llvm::CloneFunctionInto(newFn, fn, vmap,
+                            llvm::CloneFunctionChangeType::DifferentModule,
+                            returns);
+    return m;
+}
+
+// Fingerprint of 'fn' alone. Initializers of referenced constants and local
+// variables are included, their values may have been folded into the code.
+static std::string
+localFingerprint(llvm::Function *fn,
+                 const std::vector<llvm::GlobalValue *> &ref)
+{
+    std::string text;
+    llvm::raw_string_ostream os{text};
+    os << fn->getLinkage() << "\n";
+    extractFunction(fn, ref)->print(os, nullptr);
+    for (auto gv : ref) {
+	auto var = llvm::dyn_cast<llvm::GlobalVariable>(gv);
+	if (var && !var->hasPrivateLinkage() && var->hasInitializer() &&
+	    (var->isConstant() || var->hasLocalLinkage())) {
+	    os << var->getName() << " = ";
+	    var->getInitializer()->print(os);
+	    os << "\n";
+	}
+    }
+    return md5(os.str());
+}
+
+// Returns the cached module for 'key', a null pointer if the optimizer had
+// removed the function, and nothing if there is no usable entry
+static std::optional<std::unique_ptr<llvm::Module>>
+readEntry(const std::string &key)
+{
+    auto path = entryPath(key);
+    auto buffer = llvm::MemoryBuffer::getFile(path.string());
+    if (!buffer) {
+	return std::nullopt;
+    }
+    // the modification time tells pruneCache() when the entry was last used
+    std::error_code ec;
+    std::filesystem::last_write_time(
+        path, std::filesystem::file_time_type::clock::now(), ec);
+    if ((*buffer)->getBufferSize() == 0) {
+	return std::unique_ptr<llvm::Module>{};
+    }
+    auto m =
+        llvm::parseBitcodeFile((*buffer)->getMemBufferRef(), *llvmContext);
+    if (!m) {
+	llvm::consumeError(m.takeError());
+	return std::nullopt;
+    }
+    return std::move(*m);
+}
+
+static void
+writeEntry(const std::string &key, llvm::StringRef content)
+{
+    // parallel compilations may write the same entry, renaming replaces it
+    // atomically
+    auto path = entryPath(key);
+    auto tmp = path;
+    tmp += "." + std::to_string(llvm::sys::Process::getProcessId());
+
+    std::ofstream out{tmp, std::ios::binary};
+    out.write(content.data(), content.size());
+    out.close();
+
+    std::error_code ec;
+    if (!out) {
+	std::filesystem::remove(tmp, ec);
+	return;
+    }
+    std::filesystem::rename(tmp, path, ec);
+}
+
+static void
+pruneCache()
+{
+    struct Entry
+    {
+	std::filesystem::file_time_type used;
+	std::uintmax_t size;
+	std::filesystem::path path;
+    };
+    std::vector<Entry> entry;
+    std::uintmax_t size = 0;
+
+    std::error_code ec;
+    std::filesystem::directory_iterator it{opt::incrementalCache, ec};
+    for (; !ec && it != std::filesystem::directory_iterator{};
+         it.increment(ec)) {
+	// temporary files of writeEntry() have a process id as extension
+	if (it->path().extension() != ".bc") {
+	    continue;
+	}
+	std::error_code sizeEc, timeEc;
+	auto entrySize = it->file_size(sizeEc);
+	auto used = it->last_write_time(timeEc);
+	if (!sizeEc && !timeEc) {
+	    entry.push_back({used, entrySize, it->path()});
+	    size += entrySize;
+	}
+    }
+    if (size <= cacheSizeLimit) {
+	return;
+    }
+
+    std::sort(entry.begin(), entry.end(),
+              [](const Entry &a, const Entry &b) { return a.used < b.used; });
+    for (const auto &e : entry) {
+	if (size <= cacheSizeLimit) {
+	    break;
+	}
+	if (std::filesystem::remove(e.path, ec)) {
+	    size -= e.size;
+	}
+    }
+}
+
+static bool
+isCached(const llvm::Function &fn)
+{
+    return cached.contains(fn.getName());
+}
+
+// Optional passes are skipped for cached functions, loops in them, and call
+// graph SCCs of cached functions only
+static bool
+isCached(llvm::Any ir)
+{
+    if (auto fn = llvm::any_cast<const llvm::Function *>(&ir)) {
+	return isCached(**fn);
+    }
+    if (auto loop = llvm::any_cast<const llvm::Loop *>(&ir)) {
+	return isCached(*(*loop)->getHeader()->getParent());
+    }
+    if (auto scc = llvm::any_cast<const llvm::LazyCallGraph::SCC *>(&ir)) {
+	for (auto &node : **scc) {
+	    if (!isCached(node.getFunction())) {
+		return false;
+	    }
+	}
+	return true;
+    }
+    return false;
+}
+
+// Replaces the bodies of 'reused' functions by the cached modules. A null
+// module stands for a function the optimizer had removed.
+static void
+linkCachedFunctions(
+    std::vector<std::pair<llvm::Function *, std::unique_ptr<llvm::Module>>>
+        &reused)
+{
+    // local symbols are resolved by name while linking
+    std::vector<std::pair<std::string, llvm::GlobalValue::LinkageTypes>> local;
+    for (auto &gv : llvmModule->global_values()) {
+	if (gv.hasLocalLinkage() && !gv.hasPrivateLinkage() && gv.hasName()) {
+	    local.emplace_back(gv.getName().str(), gv.getLinkage());
+	    gv.setLinkage(llvm::GlobalValue::ExternalLinkage);
+	}
+    }
+
+    std::vector<std::string> removed;
+    for (auto &[fn, m] : reused) {
+	if (m) {
+	    cached.insert(fn->getName());
+	} else {
+	    removed.push_back(fn->getName().str());
+	}
+	fn->deleteBody();
+    }
+    for (auto &[fn, m] : reused) {
+	if (!m) {
+	    continue;
+	}
+	auto name = m->getName().str();
+	if (llvm::Linker::linkModules(*llvmModule, std::move(m))) {
+	    llvm::WithColor::error(llvm::errs())
+	        << "can not link cached code of '" << name << "'\n";
+	    std::exit(1);
+	}
+    }
+
+    // the group is reused as a whole, so nothing else refers to them
+    for (const auto &name : removed) {
+	auto fn = llvmModule->getFunction(name);
+	if (fn && fn->use_empty()) {
+	    fn->eraseFromParent();
+	}
+    }
+    for (const auto &[name, linkage] : local) {
+	if (auto gv = llvmModule->getNamedValue(name)) {
+	    gv->setLinkage(linkage);
+	}
+    }
+}
+
+void
+loadCachedFunctions(llvm::PassInstrumentationCallbacks &pic)
+{
+    cached.clear();
+    fresh.clear();
+    localGlobal.clear();
+    if (opt::incrementalCache.empty()) {
+	return;
+    }
+
+    // fingerprints, the defined functions each one refers to, and groups of
+    // functions sharing local symbols
+    std::vector<llvm::Function *> defined;
+    std::unordered_map<llvm::Function *, std::string> fingerprint;
+    std::unordered_map<llvm::Function *, std::vector<llvm::Function *>> callee;
+    llvm::EquivalenceClasses<llvm::GlobalValue *> group;
+    for (auto &fn : *llvmModule) {
+	if (fn.isDeclaration()) {
+	    continue;
+	}
+	auto ref = referencedGlobals(&fn);
+	defined.push_back(&fn);
+	fingerprint[&fn] = localFingerprint(&fn, ref);
+	group.insert(&fn);
+	for (auto gv : ref) {
+	    auto refFn = llvm::dyn_cast<llvm::Function>(gv);
+	    if (refFn && !refFn->isDeclaration()) {
+		callee[&fn].push_back(refFn);
+	    }
+	    if (gv->hasLocalLinkage() && !gv->hasPrivateLinkage()) {
+		group.unionSets(&fn, gv);
+	    }
+	}
+    }
+
+    std::unordered_map<llvm::GlobalValue *, std::vector<llvm::Function *>>
+        member;
+    for (auto fn : defined) {
+	member[group.getLeaderValue(fn)].push_back(fn);
+    }
+
+    auto settings = optimizationSettings();
+    std::vector<std::pair<llvm::Function *, std::unique_ptr<llvm::Module>>>
+        reused;
+    std::unordered_set<llvm::GlobalValue *> done;
+    for (auto fn : defined) {
+	auto leader = group.getLeaderValue(fn);
+	if (!done.insert(leader).second) {
+	    continue;
+	}
+
+	// the key covers the group and all groups reachable by calls
+	std::set<std::string> reachable;
+	std::unordered_set<llvm::GlobalValue *> visited{leader};
+	std::vector<llvm::GlobalValue *> work{leader};
+	while (!work.empty()) {
+	    auto g = work.back();
+	    work.pop_back();
+	    for (auto m : member[g]) {
+		reachable.insert(m->getName().str() + " " + fingerprint[m]);
+		for (auto c : callee[m]) {
+		    auto cg = group.getLeaderValue(c);
+		    if (visited.insert(cg).second) {
+			work.push_back(cg);
+		    }
+		}
+	    }
+	}
+	auto text = settings;
+	for (const auto &r : reachable) {
+	    text += "\n" + r;
+	}
+	auto groupKey = md5(text);
+
+	std::vector<Fresh> groupFresh;
+	std::vector<std::unique_ptr<llvm::Module>> entry;
+	bool hit = true;
+	for (auto m : member[leader]) {
+	    auto name = m->getName().str();
+	    groupFresh.push_back(
+	        {name, md5(groupKey + " " + name), m->hasLocalLinkage()});
+	    if (!hit) {
+		continue;
+	    }
+	    auto found = readEntry(groupFresh.back().key);
+	    hit = found.has_value();
+	    if (hit) {
+		entry.push_back(std::move(*found));
+	    }
+	}
+	if (!hit) {
+	    fresh.insert(fresh.end(), groupFresh.begin(), groupFresh.end());
+	    continue;
+	}
+	for (std::size_t i = 0; i < entry.size(); ++i) {
+	    reused.emplace_back(member[leader][i], std::move(entry[i]));
+	}
+    }
+
+    if (!reused.empty()) {
+	linkCachedFunctions(reused);
+	pic.registerShouldRunOptionalPassCallback(
+	    [](llvm::StringRef, llvm::Any ir) { return !isCached(ir); });
+    }
+
+    for (auto &gv : llvmModule->global_values()) {
+	if (gv.hasLocalLinkage() && !gv.hasPrivateLinkage()) {
+	    auto var = llvm::dyn_cast<llvm::GlobalVariable>(&gv);
+	    auto init = var && var->hasInitializer() ? var->getInitializer()
+	                                             : nullptr;
+	    localGlobal[gv.getName()] = {gv.getValueType(), init};
+	}
+    }
+}
+
+// Optimized code is only cached if the local globals it refers to are still
+// those of the unoptimized module. Interprocedural passes may replace them,
+// e.g. shrink a variable to a boolean or drop unused parameters.
+static bool
+refersToOriginalLocals(llvm::Function *fn,
+                       const std::vector<llvm::GlobalValue *> &ref)
+{
+    auto original = [](const llvm::GlobalValue *gv) {
+	if (!gv->hasLocalLinkage() || gv->hasPrivateLinkage()) {
+	    return true;
+	}
+	auto found = localGlobal.find(gv->getName());
+	if (found == localGlobal.end()) {
+	    return false;
+	}
+	auto var = llvm::dyn_cast<llvm::GlobalVariable>(gv);
+	auto init =
+	    var && var->hasInitializer() ? var->getInitializer() : nullptr;
+	return found->second.type == gv->getValueType() &&
+	       found->second.init == init;
+    };
+
+    if (!original(fn)) {
+	return false;
+    }
+    for (auto gv : ref) {
+	if (!original(gv)) {
+	    return false;
+	}
+    }
+    return true;
+}
+
+void
+saveCachedFunctions()
+{
+    if (fresh.empty()) {
+	return;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(opt::incrementalCache, ec);
+    if (ec) {
+	llvm::WithColor::warning(llvm::errs())
+	    << "can not create cache directory '" << opt::incrementalCache
+	    << "': " << ec.message() << "\n";
+	return;
+    }
+
+    for (const auto &f : fresh) {
+	std::string content;
+	llvm::raw_string_ostream os{content};
+	auto fn = llvmModule->getFunction(f.name);
+	if (fn && !fn->isDeclaration()) {
+	    auto ref = referencedGlobals(fn);
+	    if (!refersToOriginalLocals(fn, ref)) {
+		continue;
+	    }
+	    llvm::WriteBitcodeToFile(*extractFunction(fn, ref), os);
+	} else if (!f.localLinkage) {
+	    // only local functions can be dropped by the optimizer
+	    continue;
+	}
+	writeEntry(f.key, os.str());
+    }
+    pruneCache();
+}
+
+} // namespace gen
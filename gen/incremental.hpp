@@ -0,0 +1,25 @@
+#ifndef GEN_INCREMENTAL_HPP
+#define GEN_INCREMENTAL_HPP
+
+#include "gen.hpp"
+
+namespace gen {
+
+// Incremental recompilation with opt::incrementalCache. Each function is
+// fingerprinted before optimization, together with the types and globals it
+// refers to and the functions it can reach (their optimized code may have
+// been inlined). Functions sharing local symbols form a group that is reused
+// or optimized as a whole, because interprocedural passes specialize local
+// functions and variables for all their users.
+
+// Replaces the functions found in the cache by their optimized IR. Optional
+// passes of the pipeline run with 'pic' skip them.
+void loadCachedFunctions(llvm::PassInstrumentationCallbacks &pic);
+
+// Stores the optimized IR of the other functions in the cache. The entries
+// used least recently are removed if the cache exceeds its size limit.
+void saveCachedFunctions();
+
+} // namespace gen
+
+#endif // GEN_INCREMENTAL_HPP
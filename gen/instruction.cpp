@@ -1,3 +1,10 @@
+#include <algorithm>
+#include <unordered_set>
+
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/CodeGen/TargetLowering.h"
+#include "llvm/CodeGen/TargetSubtargetInfo.h"
+
 #include "function.hpp"
 #include "gentype.hpp"
 #include "instruction.hpp"
@@ -129,21 +136,153 @@ jumpInstruction(Value condition, Label trueLabel, Label falseLabel)
     return ib;
 }
 
+// ranges with more values are not expanded into switch cases
+static const std::uint64_t maxExpandedCaseRange = 256;
+
 JumpOrigin
 jumpInstruction(Value condition, Label defaultLabel,
-                const std::vector<CaseLabel> &caseLabel)
+                const std::vector<CaseLabel> &caseLabel,
+                const std::vector<CaseRange> &caseRange)
 {
     assert(llvmBuilder);
     assert(functionBuildingInfo.fn);
     reachableCheck();
 
+    auto expanded = caseLabel;
+    std::vector<const CaseRange *> checked;
+    for (const auto &range : caseRange) {
+	const auto &first = range.first->getValue();
+	const auto &last = range.last->getValue();
+	if ((last - first).ugt(maxExpandedCaseRange - 1)) {
+	    checked.push_back(&range);
+	    continue;
+	}
+	for (auto val = first;; ++val) {
+	    expanded.push_back({llvm::ConstantInt::get(*llvmContext, val),
+	                        range.label});
+	    if (val == last) {
+		break;
+	    }
+	}
+    }
+
     auto ib = llvmBuilder->GetInsertBlock();
+    auto checkLabel = checked.empty() ? defaultLabel : getLabel("range");
     auto sw =
-        llvmBuilder->CreateSwitch(condition, defaultLabel, caseLabel.size());
-    for (const auto &[val, label] : caseLabel) {
+        llvmBuilder->CreateSwitch(condition, checkLabel, expanded.size());
+    for (const auto &[val, label] : expanded) {
 	sw->addCase(val, label);
     }
     functionBuildingInfo.bbClosed = true;
+
+    // first <= condition <= last is checked as condition - first <= last -
+    // first with unsigned comparison
+    for (std::size_t i = 0; i < checked.size(); ++i) {
+	defineLabel(checkLabel);
+	checkLabel = i + 1 < checked.size() ? getLabel("range") : defaultLabel;
+	const auto &first = checked[i]->first->getValue();
+	const auto &last = checked[i]->last->getValue();
+	auto offset = llvmBuilder->CreateSub(condition, checked[i]->first);
+	auto size = llvm::ConstantInt::get(*llvmContext, last - first);
+	auto inRange = llvmBuilder->CreateICmpULE(offset, size);
+	jumpInstruction(inRange, checked[i]->label, checkLabel);
+    }
+    functionBuildingInfo.rangeChecks[ib] = checked.size();
+    return ib;
+}
+
+// Whether the backend lowers all cases of 'sw' with bit tests. Like the
+// backend, consecutive values with the same destination form one cluster that
+// needs two comparisons.
+static bool
+usesBitTests(llvm::SwitchInst *sw)
+{
+    auto fn = functionBuildingInfo.fn;
+    auto tli = targetMachine->getSubtargetImpl(*fn)->getTargetLowering();
+    if (!tli || sw->getNumCases() == 0) {
+	return false;
+    }
+
+    std::vector<std::pair<llvm::APInt, llvm::BasicBlock *>> caseVal;
+    std::unordered_set<llvm::BasicBlock *> dest;
+    for (const auto &c : sw->cases()) {
+	caseVal.push_back({c.getCaseValue()->getValue(), c.getCaseSuccessor()});
+	dest.insert(c.getCaseSuccessor());
+    }
+    std::sort(caseVal.begin(), caseVal.end(), [](const auto &a, const auto &b) {
+	return a.first.slt(b.first);
+    });
+
+    unsigned numCmps = 0;
+    for (std::size_t i = 0; i < caseVal.size();) {
+	auto j = i + 1;
+	while (j < caseVal.size() && caseVal[j].second == caseVal[i].second &&
+	       caseVal[j].first == caseVal[j - 1].first + 1) {
+	    ++j;
+	}
+	numCmps += j - i == 1 ? 1 : 2;
+	i = j;
+    }
+    return tli->isSuitableForBitTests(dest.size(), numCmps,
+                                      caseVal.front().first,
+                                      caseVal.back().first,
+                                      fn->getParent()->getDataLayout());
+}
+
+std::string
+switchLowering(JumpOrigin origin)
+{
+    assert(targetMachine);
+    assert(functionBuildingInfo.fn);
+
+    auto sw = llvm::dyn_cast<llvm::SwitchInst>(origin->getTerminator());
+    assert(sw);
+    assert(functionBuildingInfo.rangeChecks.contains(origin));
+    auto numRangeChecks = functionBuildingInfo.rangeChecks.at(origin);
+
+    // the same estimate the backend uses for its cost model
+    auto tti = targetMachine->getTargetTransformInfo(*functionBuildingInfo.fn);
+    unsigned jumpTableSize = 0;
+    auto numCases = sw->getNumCases();
+    auto numClusters = tti.getEstimatedNumberOfCaseClusters(
+        *sw, jumpTableSize, nullptr, nullptr);
+
+    std::string str;
+    llvm::raw_string_ostream out{str};
+    out << numCases << (numCases == 1 ? " case" : " cases");
+    if (numCases == 0) {
+	out << ", unconditional jump";
+    } else if (jumpTableSize) {
+	out << ", jump table with " << jumpTableSize << " entries";
+    } else if (usesBitTests(sw)) {
+	out << ", bit tests";
+    } else {
+	out << ", " << numClusters
+	    << (numClusters == 1 ? " comparison" : " comparisons");
+    }
+    if (numRangeChecks) {
+	out << ", " << numRangeChecks
+	    << (numRangeChecks == 1 ? " range check" : " range checks");
+    }
+    return str;
+}
+
+JumpOrigin
+indirectJumpInstruction(Value addr)
+{
+    assert(llvmBuilder);
+    assert(functionBuildingInfo.fn);
+    reachableCheck();
+
+    const auto &addressTaken = functionBuildingInfo.addressTaken;
+    auto ib = llvmBuilder->GetInsertBlock();
+    auto br = llvmBuilder->CreateIndirectBr(addr, addressTaken.size());
+    for (auto label : addressTaken) {
+	br->addDestination(label);
+    }
+    // labels whose address is taken later are added by labelAddress()
+    functionBuildingInfo.indirectJump.push_back(br);
+    functionBuildingInfo.bbClosed = true;
     return ib;
 }
 
@@ -159,6 +298,15 @@ phi(Value a, Label labelA, Value b, Label labelB, const abc::Type *type)
     return phi;
 }
 
+Value
+select(Value cond, Value trueValue, Value falseValue)
+{
+    assert(llvmBuilder);
+    reachableCheck();
+
+    return llvmBuilder->CreateSelect(cond, trueValue, falseValue);
+}
+
 void
 returnInstruction(Value val)
 {
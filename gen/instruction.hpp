@@ -1,6 +1,9 @@
 #ifndef GEN_INSTRUCTION_HPP
 #define GEN_INSTRUCTION_HPP
 
+#include <string>
+#include <vector>
+
 #include "type/type.hpp"
 
 #include "gen.hpp"
@@ -52,10 +55,29 @@ JumpOrigin jumpInstruction(Label label);
 JumpOrigin jumpInstruction(Value condition, Label trueLabel, Label falseLabel);
 
 using CaseLabel = std::pair<ConstantInt, Label>;
+
+// case for all values from 'first' to 'last' (both included)
+struct CaseRange
+{
+	ConstantInt first;
+	ConstantInt last;
+	Label label;
+};
+
+// Small ranges become cases of the switch such that the backend can use jump
+// tables or bit tests. Larger ranges are range checks for values not handled
+// by the switch.
 JumpOrigin jumpInstruction(Value condition, Label defaultLabel,
-                           const std::vector<CaseLabel> &caseLabel);
+                           const std::vector<CaseLabel> &caseLabel,
+                           const std::vector<CaseRange> &caseRange = {});
+// Describes how the backend is expected to lower the switch created by the
+// jumpInstruction() above, e.g. "jump table with 26 entries"
+std::string switchLowering(JumpOrigin origin);
+// jump to an address from labelAddress()
+JumpOrigin indirectJumpInstruction(Value addr);
 
 Value phi(Value a, Label labelA, Value b, Label labelB, const abc::Type *type);
+Value select(Value cond, Value trueValue, Value falseValue);
 
 void returnInstruction(Value val);
 void reachableCheck();
@@ -0,0 +1,128 @@
+#include "llvm/IR/Intrinsics.h"
+
+#include "function.hpp"
+#include "instruction.hpp"
+#include "intrinsic.hpp"
+
+namespace gen {
+
+static std::size_t
+numArgs(IntrinsicOp op)
+{
+    return op == FSHL ? 3 : 1;
+}
+
+Value
+intrinsic(IntrinsicOp op, const std::vector<Value> &arg)
+{
+    assert(llvmBuilder);
+    assert(functionBuildingInfo.fn);
+    assert(arg.size() == numArgs(op));
+    reachableCheck();
+
+    auto type = arg[0]->getType();
+    // ctlz and cttz are also defined for zero, i.e. return the bit width
+    auto isZeroPoison = llvm::ConstantInt::getFalse(*llvmContext);
+
+    switch (op) {
+    case CTPOP:
+	return llvmBuilder->CreateUnaryIntrinsic(llvm::Intrinsic::ctpop,
+	                                         arg[0]);
+    case CTLZ:
+	return llvmBuilder->CreateIntrinsic(llvm::Intrinsic::ctlz, {type},
+	                                    {arg[0], isZeroPoison});
+    case CTTZ:
+	return llvmBuilder->CreateIntrinsic(llvm::Intrinsic::cttz, {type},
+	                                    {arg[0], isZeroPoison});
+    case BSWAP:
+	return llvmBuilder->CreateUnaryIntrinsic(llvm::Intrinsic::bswap,
+	                                         arg[0]);
+    case FSHL:
+	return llvmBuilder->CreateIntrinsic(llvm::Intrinsic::fshl, {type},
+	                                    {arg[0], arg[1], arg[2]});
+    default:
+	assert(0);
+	return nullptr;
+    }
+}
+
+Constant
+intrinsic(IntrinsicOp op, const std::vector<Constant> &arg)
+{
+    assert(llvmContext);
+    assert(arg.size() == numArgs(op));
+
+    std::vector<llvm::APInt> val;
+    for (auto a : arg) {
+	auto c = llvm::dyn_cast<llvm::ConstantInt>(a);
+	assert(c);
+	val.push_back(c->getValue());
+    }
+    auto numBits = val[0].getBitWidth();
+
+    llvm::APInt result;
+    switch (op) {
+    case CTPOP:
+	result = llvm::APInt(numBits, val[0].popcount());
+	break;
+    case CTLZ:
+	result = llvm::APInt(numBits, val[0].countl_zero());
+	break;
+    case CTTZ:
+	result = llvm::APInt(numBits, val[0].countr_zero());
+	break;
+    case BSWAP:
+	result = val[0].byteSwap();
+	break;
+    case FSHL: {
+	// shift amount is taken modulo the bit width
+	auto shift = val[2].urem(numBits);
+	result = shift ? val[0].shl(shift) | val[1].lshr(numBits - shift)
+	               : val[0];
+	break;
+    }
+    default:
+	assert(0);
+	return nullptr;
+    }
+    return llvm::ConstantInt::get(*llvmContext, result);
+}
+
+void
+prefetch(Value addr, bool write, unsigned locality)
+{
+    assert(llvmBuilder);
+    assert(functionBuildingInfo.fn);
+    assert(locality <= 3);
+    reachableCheck();
+
+    auto i32Type = llvm::Type::getInt32Ty(*llvmContext);
+    auto rw = llvm::ConstantInt::get(i32Type, write ? 1 : 0);
+    auto loc = llvm::ConstantInt::get(i32Type, locality);
+    auto dataCache = llvm::ConstantInt::get(i32Type, 1);
+    llvmBuilder->CreateIntrinsic(llvm::Intrinsic::prefetch, {addr->getType()},
+                                 {addr, rw, loc, dataCache});
+}
+
+void
+assume(Value cond)
+{
+    assert(llvmBuilder);
+    assert(functionBuildingInfo.fn);
+    reachableCheck();
+
+    llvmBuilder->CreateAssumption(cond);
+}
+
+Value
+expect(Value val, Value expectedVal)
+{
+    assert(llvmBuilder);
+    assert(functionBuildingInfo.fn);
+    reachableCheck();
+
+    return llvmBuilder->CreateIntrinsic(llvm::Intrinsic::expect,
+                                        {val->getType()}, {val, expectedVal});
+}
+
+} // namespace gen
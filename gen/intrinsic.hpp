@@ -0,0 +1,28 @@
+#ifndef GEN_INTRINSIC_HPP
+#define GEN_INTRINSIC_HPP
+
+#include <vector>
+
+#include "gen.hpp"
+
+namespace gen {
+
+enum IntrinsicOp
+{
+    CTPOP, // population count
+    CTLZ,  // count leading zeros
+    CTTZ,  // count trailing zeros
+    BSWAP, // byte swap
+    FSHL,  // funnel shift left
+};
+
+Value intrinsic(IntrinsicOp op, const std::vector<Value> &arg);
+Constant intrinsic(IntrinsicOp op, const std::vector<Constant> &arg);
+
+void prefetch(Value addr, bool write, unsigned locality);
+void assume(Value cond);
+Value expect(Value val, Value expectedVal);
+
+} // namespace gen
+
+#endif // GEN_INTRINSIC_HPP
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "function.hpp"
 #include "instruction.hpp"
 #include "label.hpp"
@@ -25,4 +27,37 @@ defineLabel(Label label)
     functionBuildingInfo.bbClosed = false;
 }
 
+void
+declareLabel(const char *name, Label label)
+{
+    assert(functionBuildingInfo.fn);
+    functionBuildingInfo.label[name] = label;
+}
+
+Label
+findLabel(const char *name)
+{
+    if (!functionBuildingInfo.fn) {
+	return nullptr;
+    }
+    auto found = functionBuildingInfo.label.find(name);
+    return found != functionBuildingInfo.label.end() ? found->second : nullptr;
+}
+
+Constant
+labelAddress(Label label)
+{
+    assert(functionBuildingInfo.fn);
+    auto &addressTaken = functionBuildingInfo.addressTaken;
+    if (std::find(addressTaken.begin(), addressTaken.end(), label) ==
+        addressTaken.end()) {
+	// each indirect jump can reach each label whose address is taken
+	addressTaken.push_back(label);
+	for (auto indirectJump : functionBuildingInfo.indirectJump) {
+	    indirectJump->addDestination(label);
+	}
+    }
+    return llvm::BlockAddress::get(functionBuildingInfo.fn, label);
+}
+
 } // namespace gen
@@ -9,6 +9,15 @@ Label getLabel(const char *name = "");
 
 void defineLabel(Label label);
 
+// Labels of the current function can be looked up by name. Returns nullptr
+// outside of a function or if the function has no label 'name'.
+void declareLabel(const char *name, Label label);
+Label findLabel(const char *name);
+
+// Address of a label of the current function. It can only be used as target
+// of an indirect jump within this function.
+Constant labelAddress(Label label);
+
 } // namespace gen
 
 #endif // GEN_LABEL_HPP
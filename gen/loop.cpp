@@ -0,0 +1,102 @@
+#include <vector>
+
+#include "llvm/IR/Metadata.h"
+
+#include "function.hpp"
+#include "loop.hpp"
+
+namespace gen {
+
+bool
+LoopHint::empty() const
+{
+    return !unrollFull && !noUnroll && !unrollCount && !vectorizeWidth &&
+           !interleaveCount;
+}
+
+static llvm::Metadata *
+loopProperty(const char *name)
+{
+    return llvm::MDNode::get(*llvmContext,
+                             llvm::MDString::get(*llvmContext, name));
+}
+
+static llvm::Metadata *
+loopProperty(const char *name, llvm::Constant *val)
+{
+    llvm::Metadata *md[] = {
+	llvm::MDString::get(*llvmContext, name),
+	llvm::ConstantAsMetadata::get(val),
+    };
+    return llvm::MDNode::get(*llvmContext, md);
+}
+
+static llvm::Metadata *
+loopProperty(const char *name, unsigned val)
+{
+    auto i32Type = llvm::Type::getInt32Ty(*llvmContext);
+    return loopProperty(name, llvm::ConstantInt::get(i32Type, val));
+}
+
+static llvm::MDNode *
+getLoopID(const LoopHint &hint)
+{
+    // first operand is a placeholder for the self reference that makes the
+    // loop ID distinct
+    std::vector<llvm::Metadata *> md = {nullptr};
+
+    // an annotated loop is expected to terminate or to have side effects
+    md.push_back(loopProperty("llvm.loop.mustprogress"));
+    if (hint.noUnroll) {
+	md.push_back(loopProperty("llvm.loop.unroll.disable"));
+    } else if (hint.unrollFull) {
+	md.push_back(loopProperty("llvm.loop.unroll.full"));
+    } else if (hint.unrollCount) {
+	md.push_back(loopProperty("llvm.loop.unroll.count", hint.unrollCount));
+    }
+    if (hint.vectorizeWidth) {
+	auto enable = hint.vectorizeWidth > 1;
+	md.push_back(loopProperty("llvm.loop.vectorize.enable",
+	                          llvm::ConstantInt::getBool(*llvmContext,
+	                                                     enable)));
+	md.push_back(loopProperty("llvm.loop.vectorize.width",
+	                          hint.vectorizeWidth));
+    }
+    if (hint.interleaveCount) {
+	md.push_back(loopProperty("llvm.loop.interleave.count",
+	                          hint.interleaveCount));
+    }
+
+    auto loopID = llvm::MDNode::getDistinct(*llvmContext, md);
+    loopID->replaceOperandWith(0, loopID);
+    return loopID;
+}
+
+void
+setLoopMetadata(Label header, const LoopHint &hint)
+{
+    assert(llvmContext);
+    assert(functionBuildingInfo.fn);
+    assert(header->getParent() == functionBuildingInfo.fn);
+
+    if (hint.empty()) {
+	return;
+    }
+
+    auto loopID = getLoopID(hint);
+    auto fn = functionBuildingInfo.fn;
+    for (auto bb = header->getIterator(); bb != fn->end(); ++bb) {
+	auto term = bb->getTerminator();
+	if (!term) {
+	    continue;
+	}
+	for (unsigned i = 0; i < term->getNumSuccessors(); ++i) {
+	    if (term->getSuccessor(i) == header) {
+		term->setMetadata(llvm::LLVMContext::MD_loop, loopID);
+		break;
+	    }
+	}
+    }
+}
+
+} // namespace gen
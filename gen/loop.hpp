@@ -0,0 +1,26 @@
+#ifndef GEN_LOOP_HPP
+#define GEN_LOOP_HPP
+
+#include "gen.hpp"
+
+namespace gen {
+
+struct LoopHint
+{
+    bool unrollFull = false;
+    bool noUnroll = false;
+    unsigned unrollCount = 0;
+    unsigned vectorizeWidth = 0;
+    unsigned interleaveCount = 0;
+
+    bool empty() const;
+};
+
+// Attaches the hint as 'llvm.loop' metadata to all back edges of the loop
+// starting at 'header'. Has to be called after the loop body was generated
+// and before the label for the loop exit gets defined.
+void setLoopMetadata(Label header, const LoopHint &hint);
+
+} // namespace gen
+
+#endif // GEN_LOOP_HPP
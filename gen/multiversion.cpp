@@ -0,0 +1,162 @@
+#include "llvm/IR/GlobalIFunc.h"
+#include "llvm/TargetParser/X86TargetParser.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+
+#include "multiversion.hpp"
+
+namespace gen {
+
+bool
+supportsTargetClones()
+{
+    assert(targetMachine);
+    const auto &triple = targetMachine->getTargetTriple();
+    return triple.isX86() && triple.isOSBinFormatELF();
+}
+
+static std::vector<llvm::StringRef>
+splitFeatures(llvm::StringRef clone)
+{
+    llvm::SmallVector<llvm::StringRef> feature;
+    clone.split(feature, ',', -1, false);
+    std::vector<llvm::StringRef> trimmed;
+    for (auto f : feature) {
+	trimmed.push_back(f.trim());
+    }
+    return trimmed;
+}
+
+// Same check as '__builtin_cpu_supports' in C: the CPU features are provided
+// by '__cpu_indicator_init()' of libgcc or compiler-rt in '__cpu_model' and
+// '__cpu_features2'.
+static Value
+cpuSupports(const std::vector<llvm::StringRef> &feature)
+{
+    auto i32Type = llvm::Type::getInt32Ty(*llvmContext);
+    auto mask = llvm::X86::getCpuSupportsMask(feature);
+    Value result = llvmBuilder->getTrue();
+
+    auto test = [&](llvm::Type *type, llvm::Constant *var,
+                    std::vector<Value> idx, std::uint32_t bits) {
+	auto addr = llvmBuilder->CreateInBoundsGEP(type, var, idx);
+	auto val = llvmBuilder->CreateAlignedLoad(i32Type, addr,
+	                                          llvm::Align(4));
+	auto bitMask = llvmBuilder->getInt32(bits);
+	auto bitSet = llvmBuilder->CreateAnd(val, bitMask);
+	auto cmp = llvmBuilder->CreateICmpEQ(bitSet, bitMask);
+	result = llvmBuilder->CreateAnd(result, cmp);
+    };
+
+    if (mask[0]) {
+	// struct { vendor, type, subtype, features[1] }
+	auto modelType = llvm::StructType::get(
+	    i32Type, i32Type, i32Type, llvm::ArrayType::get(i32Type, 1));
+	auto model = llvmModule->getOrInsertGlobal("__cpu_model", modelType);
+	llvm::cast<llvm::GlobalValue>(model)->setDSOLocal(true);
+	test(modelType, model,
+	     {llvmBuilder->getInt32(0), llvmBuilder->getInt32(3),
+	      llvmBuilder->getInt32(0)},
+	     mask[0]);
+    }
+    auto features2Type = llvm::ArrayType::get(i32Type, 3);
+    for (std::size_t i = 1; i < mask.size(); ++i) {
+	if (!mask[i]) {
+	    continue;
+	}
+	auto features2 =
+	    llvmModule->getOrInsertGlobal("__cpu_features2", features2Type);
+	llvm::cast<llvm::GlobalValue>(features2)->setDSOLocal(true);
+	test(features2Type, features2,
+	     {llvmBuilder->getInt32(0), llvmBuilder->getInt32(i - 1)},
+	     mask[i]);
+    }
+    return result;
+}
+
+std::string
+targetClones(const char *ident, const std::vector<std::string> &clones)
+{
+    assert(llvmModule);
+    assert(supportsTargetClones());
+
+    auto fn = llvmModule->getFunction(ident);
+    assert(fn && !fn->isDeclaration());
+
+    for (const auto &clone : clones) {
+	if (clone == "default") {
+	    continue;
+	}
+	auto feature = splitFeatures(clone);
+	if (feature.empty()) {
+	    return "empty feature list";
+	}
+	for (auto f : feature) {
+	    if (!llvm::X86::validateCpuSupports(f)) {
+		return "unknown CPU feature '" + f.str() + "'";
+	    }
+	}
+    }
+
+    // the function becomes the default version and its symbol the ifunc
+    auto linkage = fn->getLinkage();
+    fn->setName(std::string{ident} + ".default");
+    fn->setLinkage(llvm::GlobalValue::InternalLinkage);
+
+    auto resolverType =
+        llvm::FunctionType::get(llvmBuilder->getPtrTy(), false);
+    auto resolver = llvm::Function::Create(
+        resolverType, llvm::GlobalValue::InternalLinkage,
+        std::string{ident} + ".resolver", *llvmModule);
+    auto ifunc = llvm::GlobalIFunc::create(fn->getFunctionType(), 0, linkage,
+                                           ident, resolver, llvmModule.get());
+    fn->replaceAllUsesWith(ifunc);
+
+    auto savedInsertBlock = llvmBuilder->GetInsertBlock();
+    auto entry = llvm::BasicBlock::Create(*llvmContext, "entry", resolver);
+    llvmBuilder->SetInsertPoint(entry);
+
+    auto initType =
+        llvm::FunctionType::get(llvmBuilder->getVoidTy(), false);
+    auto init = llvmModule->getOrInsertFunction("__cpu_indicator_init",
+                                                initType);
+    llvm::cast<llvm::GlobalValue>(init.getCallee())->setDSOLocal(true);
+    llvmBuilder->CreateCall(init);
+
+    auto baseFeatures =
+        fn->getFnAttribute("target-features").getValueAsString();
+    for (const auto &clone : clones) {
+	if (clone == "default") {
+	    continue;
+	}
+	auto feature = splitFeatures(clone);
+
+	llvm::ValueToValueMapTy vmap;
+	auto cloneFn = llvm::CloneFunction(fn, vmap);
+	std::string cloneName = std::string{ident} + ".";
+	std::string cloneFeatures = baseFeatures.str();
+	for (std::size_t i = 0; i < feature.size(); ++i) {
+	    cloneName += (i ? "_" : "") + feature[i].str();
+	    cloneFeatures += (cloneFeatures.empty() ? "+" : ",+") +
+	                     feature[i].str();
+	}
+	cloneFn->setName(cloneName);
+	cloneFn->addFnAttr("target-features", cloneFeatures);
+
+	auto found = llvm::BasicBlock::Create(*llvmContext, "found", resolver);
+	auto next = llvm::BasicBlock::Create(*llvmContext, "next", resolver);
+	llvmBuilder->CreateCondBr(cpuSupports(feature), found, next);
+	llvmBuilder->SetInsertPoint(found);
+	llvmBuilder->CreateRet(cloneFn);
+	llvmBuilder->SetInsertPoint(next);
+    }
+    llvmBuilder->CreateRet(fn);
+
+    if (savedInsertBlock) {
+	llvmBuilder->SetInsertPoint(savedInsertBlock);
+    } else {
+	llvmBuilder->ClearInsertionPoint();
+    }
+    return "";
+}
+
+} // namespace gen
@@ -0,0 +1,26 @@
+#ifndef GEN_MULTIVERSION_HPP
+#define GEN_MULTIVERSION_HPP
+
+#include <string>
+#include <vector>
+
+#include "gen.hpp"
+
+namespace gen {
+
+// Function multiversioning is implemented with an ifunc, which requires an
+// x86 target with ELF object files.
+bool supportsTargetClones();
+
+// Creates a clone of the defined function 'ident' for each entry of 'clones'
+// except "default". An entry is a comma separated list of CPU features, e.g.
+// "avx2,fma", that are enabled for the clone. At load time a resolver selects
+// the first clone whose features are supported by the CPU, otherwise the
+// function as is. Returns an empty string on success, otherwise an error
+// message.
+std::string targetClones(const char *ident,
+                         const std::vector<std::string> &clones);
+
+} // namespace gen
+
+#endif // GEN_MULTIVERSION_HPP
@@ -0,0 +1,99 @@
+#include <cstdlib>
+
+#include "llvm/Passes/PassPlugin.h"
+#include "llvm/Support/WithColor.h"
+
+#include "pipeline.hpp"
+
+namespace gen {
+
+static const char *extensionPoint[] = {
+    "pipeline-start",   "peephole",       "scalar-optimizer-late",
+    "vectorizer-start", "optimizer-last",
+};
+
+bool
+isExtensionPoint(const std::string &name)
+{
+    for (auto ep : extensionPoint) {
+	if (name == ep) {
+	    return true;
+	}
+    }
+    return false;
+}
+
+template <typename PassManager>
+static void
+parsePassPipeline(llvm::PassBuilder &pb, PassManager &pm,
+                  const std::string &text)
+{
+    if (auto error = pb.parsePassPipeline(pm, text)) {
+	llvm::WithColor::error(llvm::errs())
+	    << "invalid pass pipeline '" << text
+	    << "': " << llvm::toString(std::move(error)) << "\n";
+	std::exit(1);
+    }
+}
+
+static std::vector<llvm::PassPlugin> &
+getPassPlugins()
+{
+    // plugins stay loaded for all translation units
+    static std::vector<llvm::PassPlugin> plugin;
+    static std::size_t numLoaded;
+
+    for (; numLoaded < opt::passPlugin.size(); ++numLoaded) {
+	const auto &path = opt::passPlugin[numLoaded];
+	auto loaded = llvm::PassPlugin::Load(path);
+	if (auto error = loaded.takeError()) {
+	    llvm::WithColor::error(llvm::errs())
+	        << "can not load pass plugin '" << path
+	        << "': " << llvm::toString(std::move(error)) << "\n";
+	    std::exit(1);
+	}
+	plugin.push_back(*loaded);
+    }
+    return plugin;
+}
+
+void
+registerPassCallbacks(llvm::PassBuilder &pb)
+{
+    for (auto &plugin : getPassPlugins()) {
+	plugin.registerPassBuilderCallbacks(pb);
+    }
+
+    // the signatures of the callbacks differ, all get the pass manager first
+    for (const auto &[ep, text] : opt::extensionPointPasses) {
+	auto parse = [&pb, text](auto &pm, auto &&...) {
+	    parsePassPipeline(pb, pm, text);
+	};
+	if (ep == "pipeline-start") {
+	    pb.registerPipelineStartEPCallback(parse);
+	} else if (ep == "peephole") {
+	    pb.registerPeepholeEPCallback(parse);
+	} else if (ep == "scalar-optimizer-late") {
+	    pb.registerScalarOptimizerLateEPCallback(parse);
+	} else if (ep == "vectorizer-start") {
+	    pb.registerVectorizerStartEPCallback(parse);
+	} else if (ep == "optimizer-last") {
+	    pb.registerOptimizerLastEPCallback(parse);
+	} else {
+	    assert(0);
+	}
+    }
+}
+
+llvm::ModulePassManager
+buildPassPipeline(llvm::PassBuilder &pb)
+{
+    if (opt::passPipeline.empty()) {
+	return pb.buildPerModuleDefaultPipeline(getOptimizationLevel());
+    }
+    llvm::ModulePassManager mpm;
+    parsePassPipeline(pb, mpm, opt::passPipeline);
+    return mpm;
+}
+
+} // namespace gen
@@ -0,0 +1,26 @@
+#ifndef GEN_PIPELINE_HPP
+#define GEN_PIPELINE_HPP
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gen.hpp"
+
+namespace gen {
+
+// Extension points of the default pipeline where passes can be inserted with
+// opt::extensionPointPasses, e.g. "vectorizer-start"
+bool isExtensionPoint(const std::string &name);
+
+// Loads the pass plugins of opt::passPlugin and registers the passes given for
+// extension points. Has to be called before analyses are registered.
+void registerPassCallbacks(llvm::PassBuilder &pb);
+
+// Returns the pipeline given by opt::passPipeline, otherwise the default
+// pipeline for the optimization level
+llvm::ModulePassManager buildPassPipeline(llvm::PassBuilder &pb);
+
+} // namespace gen
+
+#endif // GEN_PIPELINE_HPP
@@ -1,3 +1,5 @@
+#include <optional>
+#include <string>
 #include <system_error>
 
 #ifdef SUPPORT_SOLARIS
@@ -5,47 +7,114 @@
 #include "llvm/Support/Solaris/sys/regset.h"
 #endif // SUPPORT_SOLARIS
 
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/IR/LegacyPassManager.h"
+#include "llvm/MC/TargetRegistry.h"
 #include "llvm/Support/FileSystem.h"
 
+#include "debuginfo.hpp"
 #include "gen.hpp"
+#include "incremental.hpp"
+#include "pipeline.hpp"
 #include "print.hpp"
+#include "remark.hpp"
 
 namespace gen {
 
-void
-print(std::filesystem::path path, FileType fileType)
+static std::unique_ptr<llvm::TargetMachine>
+cloneTargetMachine()
 {
-    assert(llvmContext);
-    assert(targetMachine);
-    std::error_code ec;
-    auto f = llvm::raw_fd_ostream{path.c_str(), ec, llvm::sys::fs::OF_None};
+    auto tm = targetMachine;
+    return std::unique_ptr<llvm::TargetMachine>(
+        tm->getTarget().createTargetMachine(
+            tm->getTargetTriple(), tm->getTargetCPU(),
+            tm->getTargetFeatureString(), tm->Options,
+            tm->getRelocationModel(), tm->getCodeModel(), tm->getOptLevel()));
+}
 
-    if (ec) {
-	llvm::errs() << "Could not open file: " << path << ". " << ec.message()
-	             << "\n";
-	std::exit(1);
+// Code generation for partitions of the module in parallel. Each thread uses
+// its own context and target machine. Local symbols are kept in the partition
+// that references them, otherwise they would clash with those of other
+// translation units.
+static std::vector<std::filesystem::path>
+printParallel(const std::filesystem::path &path)
+{
+    std::vector<std::filesystem::path> partPath;
+    std::vector<std::unique_ptr<llvm::raw_fd_ostream>> part;
+    std::vector<llvm::raw_pwrite_stream *> os;
+    for (unsigned i = 0; i < opt::parallelCodegen; ++i) {
+	partPath.push_back(path);
+	partPath.back().replace_extension(std::to_string(i) +
+	                                  path.extension().string());
+	std::error_code ec;
+	part.push_back(std::make_unique<llvm::raw_fd_ostream>(
+	    partPath.back().c_str(), ec, llvm::sys::fs::OF_None));
+	if (ec) {
+	    llvm::errs() << "Could not open file: " << partPath.back()
+	                 << ". " << ec.message() << "\n";
+	    std::exit(1);
+	}
+	os.push_back(part.back().get());
     }
+    llvm::splitCodeGen(*llvmModule, os, {}, cloneTargetMachine,
+#if LLVM_MAJOR_VERSION >= 18
+                       llvm::CodeGenFileType::ObjectFile,
+#else
+                       llvm::CodeGenFileType::CGFT_ObjectFile,
+#endif
+                       true);
+    return partPath;
+}
+
+std::vector<std::filesystem::path>
+print(std::filesystem::path path, FileType fileType,
+      const std::filesystem::path &recordPath)
+{
+    assert(llvmContext);
+    assert(targetMachine);
+    finalizeDebugInfo();
 
     llvm::LoopAnalysisManager LAM;
     llvm::FunctionAnalysisManager FAM;
     llvm::CGSCCAnalysisManager CGAM;
     llvm::ModuleAnalysisManager MAM;
 
-    llvm::PassBuilder PB{targetMachine};
+    llvm::PassInstrumentationCallbacks PIC;
+    llvm::PassBuilder PB{targetMachine, llvm::PipelineTuningOptions{},
+                         std::nullopt, &PIC};
+    registerPassCallbacks(PB);
     PB.registerModuleAnalyses(MAM);
     PB.registerCGSCCAnalyses(CGAM);
     PB.registerFunctionAnalyses(FAM);
     PB.registerLoopAnalyses(LAM);
     PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
 
-    llvm::ModulePassManager MPM =
-        PB.buildPerModuleDefaultPipeline(getOptimizationLevel());
+    loadCachedFunctions(PIC);
+    llvm::ModulePassManager MPM = buildPassPipeline(PB);
+    beginRemarks(recordPath);
     MPM.run(*llvmModule, MAM);
+    saveCachedFunctions();
+
+    if (fileType == OBJECT_FILE && opt::parallelCodegen > 1) {
+	// 'path' is only created when the partitions are linked
+	auto partPath = printParallel(path);
+	endRemarks();
+	return partPath;
+    }
+
+    std::error_code ec;
+    auto f = llvm::raw_fd_ostream{path.c_str(), ec, llvm::sys::fs::OF_None};
+
+    if (ec) {
+	llvm::errs() << "Could not open file: " << path << ". " << ec.message()
+	             << "\n";
+	std::exit(1);
+    }
 
     if (fileType == LLVM_FILE) {
+	endRemarks();
 	llvmModule->print(f, nullptr);
-	return;
+	return {};
     }
 
     llvm::legacy::PassManager pass;
@@ -63,7 +132,12 @@ print(std::filesystem::path path, FileType fileType)
 	std::exit(1);
     }
     pass.run(*llvmModule);
+    endRemarks();
     f.flush();
+    if (fileType == OBJECT_FILE) {
+	return {path};
+    }
+    return {};
 }
 
 } // namespace gen
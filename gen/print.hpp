@@ -2,6 +2,7 @@
 #define GEN_PRINT_HPP
 
 #include <filesystem>
+#include <vector>
 
 namespace gen {
 
@@ -12,7 +13,15 @@ enum FileType
     LLVM_FILE,
 };
 
-void print(std::filesystem::path path, FileType fileType = LLVM_FILE);
+// Optimizes the module and writes it to 'path'. Optimization remarks are
+// saved to 'recordPath' if requested, see beginRemarks().
+//
+// With opt::parallelCodegen > 1 an object file is generated in partitions by
+// multiple threads. Then the partitions are written to "x.0.o", "x.1.o", ...
+// for 'path' "x.o" instead and have to be linked. Returns the object files.
+std::vector<std::filesystem::path> print(
+    std::filesystem::path path, FileType fileType = LLVM_FILE,
+    const std::filesystem::path &recordPath = {});
 
 } // namespace gen
 
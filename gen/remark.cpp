@@ -0,0 +1,172 @@
+#include <optional>
+
+#include "llvm/IR/DiagnosticHandler.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/LLVMRemarkStreamer.h"
+#include "llvm/Remarks/RemarkStreamer.h"
+#include "llvm/Support/Regex.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/WithColor.h"
+
+#include "remark.hpp"
+
+namespace gen {
+
+namespace {
+
+class RemarkHandler : public llvm::DiagnosticHandler
+{
+    public:
+	RemarkHandler()
+	{
+	    init(passed, opt::remarkPass);
+	    init(missed, opt::remarkMissed);
+	    init(analysis, opt::remarkAnalysis);
+	}
+
+	bool
+	isPassedOptRemarkEnabled(llvm::StringRef passName) const override
+	{
+	    return passed && passed->match(passName);
+	}
+
+	bool
+	isMissedOptRemarkEnabled(llvm::StringRef passName) const override
+	{
+	    return missed && missed->match(passName);
+	}
+
+	bool
+	isAnalysisRemarkEnabled(llvm::StringRef passName) const override
+	{
+	    return analysis && analysis->match(passName);
+	}
+
+	bool
+	isAnyRemarkEnabled() const override
+	{
+	    return passed || missed || analysis;
+	}
+
+	bool handleDiagnostics(const llvm::DiagnosticInfo &di) override;
+
+    private:
+	std::optional<llvm::Regex> passed, missed, analysis;
+
+	static void init(std::optional<llvm::Regex> &regex,
+	                 const std::string &pattern);
+};
+
+} // namespace
+
+void
+RemarkHandler::init(std::optional<llvm::Regex> &regex,
+                    const std::string &pattern)
+{
+    if (pattern.empty()) {
+	return;
+    }
+    regex.emplace(pattern);
+    std::string error;
+    if (!regex->isValid(error)) {
+	llvm::WithColor::error(llvm::errs())
+	    << "invalid regular expression '" << pattern << "': " << error
+	    << "\n";
+	std::exit(1);
+    }
+}
+
+bool
+RemarkHandler::handleDiagnostics(const llvm::DiagnosticInfo &di)
+{
+    auto remark = llvm::dyn_cast<llvm::DiagnosticInfoOptimizationBase>(&di);
+    if (!remark) {
+	// errors and warnings of the backend are printed by LLVMContext
+	return false;
+    }
+    if (!remark->isEnabled()) {
+	// only saved in the optimization record
+	return true;
+    }
+
+    std::string loc = moduleName;
+    if (remark->isLocationAvailable()) {
+	auto diLoc = remark->getLocation();
+	loc = std::string{diLoc.getRelativePath()} + ":" +
+	      std::to_string(diLoc.getLine()) + ":" +
+	      std::to_string(diLoc.getColumn());
+    }
+
+    const char *option;
+    switch (di.getKind()) {
+    case llvm::DK_OptimizationRemark:
+    case llvm::DK_MachineOptimizationRemark:
+	option = "-Rpass";
+	break;
+    case llvm::DK_OptimizationRemarkMissed:
+    case llvm::DK_MachineOptimizationRemarkMissed:
+	option = "-Rpass-missed";
+	break;
+    case llvm::DK_OptimizationRemarkAnalysis:
+    case llvm::DK_OptimizationRemarkAnalysisFPCommute:
+    case llvm::DK_OptimizationRemarkAnalysisAliasing:
+    case llvm::DK_MachineOptimizationRemarkAnalysis:
+	option = "-Rpass-analysis";
+	break;
+    default:
+	// e.g. a loop transformation that was requested but failed, this
+	// is a warning and not selected with one of the -Rpass options
+	llvm::WithColor::warning(llvm::errs(), loc)
+	    << remark->getMsg() << " [" << remark->getPassName() << "]\n";
+	return true;
+    }
+
+    llvm::WithColor::remark(llvm::errs(), loc)
+        << remark->getMsg() << " [" << option << "=" << remark->getPassName()
+        << "]\n";
+    return true;
+}
+
+static std::unique_ptr<llvm::ToolOutputFile> optRecord;
+
+bool
+remarksEnabled()
+{
+    return !opt::remarkPass.empty() || !opt::remarkMissed.empty() ||
+           !opt::remarkAnalysis.empty() || !opt::optRecordFormat.empty();
+}
+
+void
+beginRemarks(const std::filesystem::path &recordPath)
+{
+    assert(llvmContext);
+    llvmContext->setDiagnosticHandler(std::make_unique<RemarkHandler>());
+    if (opt::optRecordFormat.empty()) {
+	return;
+    }
+
+    auto file = llvm::setupLLVMOptimizationRemarks(
+        *llvmContext, recordPath.string(), "", opt::optRecordFormat, false);
+    if (auto error = file.takeError()) {
+	llvm::WithColor::error(llvm::errs())
+	    << "can not save optimization record to " << recordPath.string()
+	    << ": " << llvm::toString(std::move(error)) << "\n";
+	std::exit(1);
+    }
+    optRecord = std::move(*file);
+}
+
+void
+endRemarks()
+{
+    assert(llvmContext);
+    if (optRecord) {
+	// the streamers write to the file, so they are removed first
+	llvmContext->setLLVMRemarkStreamer(nullptr);
+	llvmContext->setMainRemarkStreamer(nullptr);
+	optRecord->keep();
+	optRecord.reset();
+    }
+}
+
+} // namespace gen
@@ -0,0 +1,22 @@
+#ifndef GEN_REMARK_HPP
+#define GEN_REMARK_HPP
+
+#include <filesystem>
+
+#include "gen.hpp"
+
+namespace gen {
+
+// Optimization remarks need the source locations of instructions, see
+// initDebugInfo()
+bool remarksEnabled();
+
+// Reports remarks of passes selected by opt::remarkPass, opt::remarkMissed and
+// opt::remarkAnalysis while optimizing and generating code for the module.
+// If opt::optRecordFormat is set, all remarks are also saved to 'recordPath'.
+void beginRemarks(const std::filesystem::path &recordPath);
+void endRemarks();
+
+} // namespace gen
+
+#endif // GEN_REMARK_HPP
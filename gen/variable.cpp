@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -8,7 +9,10 @@
 #include "llvm/Support/Solaris/sys/regset.h"
 #endif // SUPPORT_SOLARIS
 
+#include "llvm/ADT/MapVector.h"
 #include "llvm/Analysis/ConstantFolding.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/Transforms/Utils/Local.h"
 
 #include "type/integertype.hpp"
 
@@ -23,14 +27,67 @@ namespace gen {
 // Map with all string literals
 static std::unordered_map<std::string, std::string> stringMap;
 
+// Map with constant objects that are used to initialize aggregates
+static std::unordered_map<Constant, llvm::GlobalVariable *> readonlyMap;
+
 // Map with all local variables
-static std::unordered_map<const char *, llvm::AllocaInst *> localVariable;
+static std::unordered_map<const char *, Value> localVariable;
 static Value lookup(const char *ident);
 
 //------------------------------------------------------------------------------
 
+// Object files are generated as position independent code, so they can also
+// be linked into a shared library. Hence thread-local variables get the
+// general-dynamic model. The backend selects a cheaper model that the
+// relocation model allows, e.g. local-dynamic for variables of this module
+// or local-exec for static code, and when linking an executable the linker
+// relaxes the accesses to a fixed offset from the thread pointer.
+static void
+setThreadLocalMode(llvm::GlobalVariable *var, bool threadLocal)
+{
+    var->setThreadLocalMode(threadLocal
+                                ? llvm::GlobalValue::GeneralDynamicTLSModel
+                                : llvm::GlobalValue::NotThreadLocal);
+}
+
+// Objects of a readonly type, or arrays of them, are never modified. They
+// are emitted as constants such that the optimizer can fold loads from them.
+static bool
+isReadonly(const abc::Type *type)
+{
+    if (type->hasConstFlag()) {
+	return true;
+    }
+    return type->isArray() && isReadonly(type->refType());
+}
+
+// Variables are aligned at least as required by their type. With 'alignas' a
+// larger alignment can be requested.
+static llvm::Align
+variableAlignment(llvm::Type *llvmVarType, std::size_t alignment)
+{
+    return std::max(getAlignment(llvmVarType),
+                    llvm::Align(std::max<std::size_t>(alignment, 1)));
+}
+
+// The value type of a global can differ from the type of the variable, e.g.
+// for a sparse array initializer. The alignment is determined by the latter.
+static void
+setAlignment(llvm::GlobalVariable *var, llvm::Type *llvmVarType,
+             std::size_t alignment)
+{
+    // without explicit alignment a global is aligned as required by the ABI
+    auto &dl = llvmModule->getDataLayout();
+    auto valueType = var->getValueType();
+    auto align = variableAlignment(llvmVarType, alignment);
+    if (align > var->getAlign().value_or(dl.getABITypeAlign(valueType))) {
+	var->setAlignment(align);
+    }
+}
+
 bool
-externalVariableDeclaration(const char *ident, const abc::Type *varType)
+externalVariableDeclaration(const char *ident, const abc::Type *varType,
+                            bool threadLocal)
 {
     assert(llvmModule);
     assert(!varType->isFunction());
@@ -47,17 +104,21 @@ externalVariableDeclaration(const char *ident, const abc::Type *varType)
     auto llvmVarType = convert(varType);
     assert(llvmVarType);
 
-    new llvm::GlobalVariable(*llvmModule, llvmVarType,
-                             /*isConstant=*/false,
-                             /*Linkage=*/llvm::GlobalValue::ExternalLinkage,
-                             /*Initializer=*/nullptr,
-                             /*Name=*/ident, nullptr);
+    auto var = new llvm::GlobalVariable(
+        *llvmModule, llvmVarType,
+        /*isConstant=*/isReadonly(varType),
+        /*Linkage=*/llvm::GlobalValue::ExternalLinkage,
+        /*Initializer=*/nullptr,
+        /*Name=*/ident, nullptr);
+    setThreadLocalMode(var, threadLocal);
+    setAlignment(var, llvmVarType, 0);
     return true;
 }
 
 void
 globalVariableDefinition(const char *ident, const abc::Type *varType,
-                         Constant initialValue)
+                         Constant initialValue, bool threadLocal,
+                         std::size_t alignment)
 {
     assert(llvmModule);
     assert(!varType->isFunction());
@@ -73,15 +134,36 @@ globalVariableDefinition(const char *ident, const abc::Type *varType,
 	// variable exists, assert it is a global variable
 	auto var = llvm::dyn_cast<llvm::GlobalVariable>(found);
 	assert(var);
+	if (var->getValueType() != initialValue->getType()) {
+	    // replace the declaration by a global of the initializer's type
+	    auto newVar = new llvm::GlobalVariable(
+	        *llvmModule, initialValue->getType(),
+	        /*isConstant=*/false,
+	        /*Linkage=*/var->getLinkage(),
+	        /*Initializer=*/nullptr,
+	        /*Name=*/"", var);
+	    newVar->copyAttributesFrom(var);
+	    newVar->takeName(var);
+	    var->replaceAllUsesWith(newVar);
+	    var->eraseFromParent();
+	    var = newVar;
+	}
 	var->setInitializer(initialValue);
+	var->setConstant(isReadonly(varType));
+	setThreadLocalMode(var, threadLocal);
+	setAlignment(var, llvmVarType, alignment);
 	return;
     }
 
-    new llvm::GlobalVariable(*llvmModule, llvmVarType,
-                             /*isConstant=*/false,
-                             /*Linkage=*/llvm::GlobalValue::InternalLinkage,
-                             /*Initializer=*/initialValue,
-                             /*Name=*/ident, nullptr);
+    // the initializer determines the value type, see getConstantArray()
+    auto var = new llvm::GlobalVariable(
+        *llvmModule, initialValue->getType(),
+        /*isConstant=*/isReadonly(varType),
+        /*Linkage=*/llvm::GlobalValue::InternalLinkage,
+        /*Initializer=*/initialValue,
+        /*Name=*/ident, nullptr);
+    setThreadLocalMode(var, threadLocal);
+    setAlignment(var, llvmVarType, alignment);
 }
 
 Constant
@@ -97,17 +179,48 @@ loadStringAddress(const char *stringLiteral)
 	stringMap[str] = ss.str();
 	auto llvmStr =
 	    llvm::ConstantDataArray::getString(*llvmContext, stringLiteral);
-	new llvm::GlobalVariable(*llvmModule, llvmStr->getType(),
-	                         /*isConstant=*/true,
-	                         /*Linkage=*/llvm::GlobalValue::InternalLinkage,
-	                         /*Initializer=*/llvmStr,
-	                         /*Name=*/ss.str().c_str());
+	auto var = new llvm::GlobalVariable(
+	    *llvmModule, llvmStr->getType(),
+	    /*isConstant=*/true,
+	    /*Linkage=*/llvm::GlobalValue::PrivateLinkage,
+	    /*Initializer=*/llvmStr,
+	    /*Name=*/ss.str().c_str());
+	// with unnamed_addr the backend puts the literal into a mergeable
+	// string section. So the linker can merge equal literals of
+	// different object files.
+	var->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+	var->setAlignment(llvm::Align(1));
     }
     return loadConstantAddress(stringMap.at(str).c_str());
 }
 
+// Returns the address of a read-only object of type 'type' with value 'val'.
+// Objects with the same value share the address.
+Constant
+loadReadonlyAddress(Constant val, const abc::Type *type)
+{
+    assert(llvmModule);
+
+    if (!readonlyMap.contains(val)) {
+	std::stringstream ss;
+	ss << ".R" << readonlyMap.size();
+	auto var = new llvm::GlobalVariable(
+	    *llvmModule, val->getType(),
+	    /*isConstant=*/true,
+	    /*Linkage=*/llvm::GlobalValue::PrivateLinkage,
+	    /*Initializer=*/val,
+	    /*Name=*/ss.str().c_str());
+	var->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+	readonlyMap[val] = var;
+    }
+    auto var = readonlyMap.at(val);
+    setAlignment(var, convert(type), 0);
+    return var;
+}
+
 Value
-localVariableDefinition(const char *ident, const abc::Type *varType)
+localVariableDefinition(const char *ident, const abc::Type *varType,
+                        std::size_t alignment)
 {
     assert(varType);
     assert(!varType->isFunction());
@@ -116,7 +229,8 @@ localVariableDefinition(const char *ident, const abc::Type *varType)
     auto llvmVarType = convert(varType);
     if (localVariable.contains(ident)) {
 	auto val = localVariable.at(ident);
-	assert(val->getAllocatedType() == llvmVarType);
+	auto var = llvm::dyn_cast<llvm::AllocaInst>(val);
+	assert(!var || var->getAllocatedType() == llvmVarType);
 	return val;
     }
 
@@ -124,14 +238,30 @@ localVariableDefinition(const char *ident, const abc::Type *varType)
     auto fn = functionBuildingInfo.fn;
     llvm::IRBuilder<> tmpBuilder(&fn->getEntryBlock(),
                                  fn->getEntryBlock().begin());
-    localVariable[ident] = tmpBuilder.CreateAlloca(llvmVarType, nullptr, ident);
-    return localVariable[ident];
+    auto var = tmpBuilder.CreateAlloca(llvmVarType, nullptr, ident);
+    auto align = variableAlignment(llvmVarType, alignment);
+    if (align > var->getAlign()) {
+	var->setAlignment(align);
+    }
+    localVariable[ident] = var;
+    return var;
+}
+
+// A local variable that is stored at a given address, e.g. a parameter
+// passed by reference or a variable that is returned in the return slot
+void
+localVariableReference(const char *ident, Value addr)
+{
+    assert(functionBuildingInfo.fn);
+    assert(!localVariable.contains(ident));
+    localVariable[ident] = addr;
 }
 
 void
 forgetAllVariables()
 {
     stringMap.clear();
+    readonlyMap.clear();
     forgetAllLocalVariables();
 }
 
@@ -149,6 +279,9 @@ lookup(const char *ident)
 	return var;
     } else if (auto fn = llvmModule->getFunction(ident)) {
 	return fn;
+    } else if (auto ifunc = llvmModule->getNamedIFunc(ident)) {
+	// function with target clones, see targetClones()
+	return ifunc;
     } else if (localVariable.contains(ident)) {
 	return localVariable.at(ident);
     } else {
@@ -170,6 +303,9 @@ loadConstantAddress(const char *ident)
 	return var;
     } else if (auto fn = llvmModule->getFunction(ident)) {
 	return fn;
+    } else if (auto ifunc = llvmModule->getNamedIFunc(ident)) {
+	// function with target clones, see targetClones()
+	return ifunc;
     } else {
 	return nullptr;
     }
@@ -184,6 +320,11 @@ loadAddress(const char *ident)
 	          << " was not defined.\n";
 	assert(0);
     }
+    auto var = llvm::dyn_cast<llvm::GlobalVariable>(addr);
+    if (var && var->isThreadLocal() && functionBuildingInfo.fn) {
+	reachableCheck();
+	return llvmBuilder->CreateThreadLocalAddress(var);
+    }
     return addr;
 }
 
@@ -249,11 +390,49 @@ pointerToIndex(const abc::Type *type, Value pointer, std::size_t index)
 
     std::vector<Value> idxList{2};
     idxList[0] = getConstantZero(abc::IntegerType::createSigned(8));
-    idxList[1] = getConstantInt(index, abc::IntegerType::createUnsigned(32));
+    idxList[1] = getConstantInt(getElementIndex(llvmType, index),
+                                abc::IntegerType::createUnsigned(32));
 
     return llvmBuilder->CreateGEP(llvmType, pointer, idxList);
 }
 
+// Alignment that is known for an address. Unless the address is derived from
+// a variable or points into a struct with explicit layout (e.g. a member of a
+// packed struct) the address is assumed to be aligned by 'assumed'.
+static llvm::Align
+knownAlignment(Value addr, llvm::Align assumed)
+{
+    auto &dl = llvmModule->getDataLayout();
+    if (auto gep = llvm::dyn_cast<llvm::GEPOperator>(addr)) {
+	auto align = knownAlignment(gep->getPointerOperand(),
+	                            getAlignment(gep->getSourceElementType()));
+	auto numBits = dl.getIndexTypeSizeInBits(gep->getType());
+	llvm::MapVector<Value, llvm::APInt> variableOffset;
+	llvm::APInt constantOffset{numBits, 0};
+	if (!gep->collectOffset(dl, numBits, variableOffset, constantOffset)) {
+	    return llvm::Align(1);
+	}
+	align = llvm::commonAlignment(align, constantOffset.getZExtValue());
+	for (const auto &[val, scale] : variableOffset) {
+	    align = llvm::commonAlignment(align, scale.getZExtValue());
+	}
+	return align;
+    } else if (auto var = llvm::dyn_cast<llvm::AllocaInst>(addr)) {
+	return var->getAlign();
+    } else if (auto arg = llvm::dyn_cast<llvm::Argument>(addr)) {
+	return arg->getParamAlign().value_or(assumed);
+    } else if (auto var = llvm::dyn_cast<llvm::GlobalVariable>(addr)) {
+	return var->getAlign().value_or(getAlignment(var->getValueType()));
+    }
+    return assumed;
+}
+
+static llvm::Align
+accessAlignment(Value addr, llvm::Type *llvmType)
+{
+    return knownAlignment(addr, getAlignment(llvmType));
+}
+
 Value
 fetch(Value addr, const abc::Type *type)
 {
@@ -262,7 +441,26 @@ fetch(Value addr, const abc::Type *type)
     assert(functionBuildingInfo.fn);
     reachableCheck();
     auto llvmType = convert(type);
-    return llvmBuilder->CreateLoad(llvmType, addr);
+    // a scalar load from a constant object with known address is folded
+    auto constAddr = llvm::dyn_cast<llvm::Constant>(addr);
+    if (constAddr && type->isScalar()) {
+	auto &dl = llvmModule->getDataLayout();
+	if (auto val = llvm::ConstantFoldLoadFromConstPtr(constAddr, llvmType,
+	                                                  dl)) {
+	    return val;
+	}
+    }
+    return llvmBuilder->CreateAlignedLoad(llvmType, addr,
+                                          accessAlignment(addr, llvmType));
+}
+
+void
+discard(Value val)
+{
+    auto inst = llvm::dyn_cast<llvm::Instruction>(val);
+    if (inst && llvm::isInstructionTriviallyDead(inst)) {
+	inst->eraseFromParent();
+    }
 }
 
 Value
@@ -271,10 +469,37 @@ store(Value val, Value addr)
     assert(llvmBuilder);
     assert(functionBuildingInfo.fn);
     reachableCheck();
-    llvmBuilder->CreateStore(val, addr);
+    llvmBuilder->CreateAlignedStore(val, addr,
+                                    accessAlignment(addr, val->getType()));
     return val;
 }
 
+void
+copy(Value destAddr, Value srcAddr, const abc::Type *type)
+{
+    assert(llvmBuilder);
+    assert(type);
+    assert(functionBuildingInfo.fn);
+    reachableCheck();
+    auto llvmType = convert(type);
+    llvmBuilder->CreateMemCpy(destAddr, accessAlignment(destAddr, llvmType),
+                              srcAddr, accessAlignment(srcAddr, llvmType),
+                              getSizeof(type));
+}
+
+void
+zero(Value addr, const abc::Type *type)
+{
+    assert(llvmBuilder);
+    assert(type);
+    assert(functionBuildingInfo.fn);
+    reachableCheck();
+    auto llvmType = convert(type);
+    auto zeroByte = llvmBuilder->getInt8(0);
+    llvmBuilder->CreateMemSet(addr, zeroByte, getSizeof(type),
+                              accessAlignment(addr, llvmType));
+}
+
 void
 printGlobalVariableList()
 {
@@ -7,14 +7,20 @@
 
 namespace gen {
 
-bool externalVariableDeclaration(const char *ident, const abc::Type *varType);
+bool externalVariableDeclaration(const char *ident, const abc::Type *varType,
+                                 bool threadLocal = false);
 
 void globalVariableDefinition(const char *ident, const abc::Type *varType,
-                              Constant initialValue = nullptr);
+                              Constant initialValue = nullptr,
+                              bool threadLocal = false,
+                              std::size_t alignment = 0);
 
 Constant loadStringAddress(const char *str);
+Constant loadReadonlyAddress(Constant val, const abc::Type *type);
 
-Value localVariableDefinition(const char *ident, const abc::Type *varType);
+Value localVariableDefinition(const char *ident, const abc::Type *varType,
+                              std::size_t alignment = 0);
+void localVariableReference(const char *ident, Value addr);
 
 void forgetAllVariables();
 void forgetAllLocalVariables();
@@ -34,7 +40,12 @@ Value pointerDifference(const abc::Type *type, Value pointer1, Value pointer2);
 Value pointerToIndex(const abc::Type *type, Value pointer, std::size_t index);
 
 Value fetch(Value addr, const abc::Type *type);
+// removes a value that is not needed if this has no side effects, e.g. the
+// load that yields the value of an assignment used as statement
+void discard(Value val);
 Value store(Value val, Value addr);
+void copy(Value destAddr, Value srcAddr, const abc::Type *type);
+void zero(Value addr, const abc::Type *type);
 
 // for debugging and educational purposes
 void printGlobalVariableList();
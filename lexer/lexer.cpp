@@ -1,6 +1,7 @@
 #include <cassert>
 #include <iostream>
 #include <optional>
+#include <set>
 #include <string>
 
 #include "util/ustr.hpp"
@@ -17,6 +18,7 @@ Token token, lastToken;
 
 static std::unordered_map<UStr, TokenKind> keyword;
 static std::set<std::filesystem::path> includedFiles_;
+static std::optional<Token> nextToken;
 
 static bool isWhiteSpace(int ch);
 static bool isDecDigit(int ch);
@@ -28,7 +30,7 @@ static TokenKind setToken(TokenKind kind, std::string processed = "");
 static unsigned hexToVal(char ch);
 static std::string parseStringLiteral();
 static unsigned parseCharacterLiteral();
-static void parseAddDirective();
+static bool parseAddDirective();
 static void parseDecimalFloatingConstant();
 static void parseHexadecimalFloatingConstant();
 
@@ -71,6 +73,8 @@ init()
 {
     macro::init();
     includedFiles_.clear();
+    nextToken.reset();
+    keyword[UStr::create("alignas")] = TokenKind::ALIGNAS;
     keyword[UStr::create("array")] = TokenKind::ARRAY;
     keyword[UStr::create("assert")] = TokenKind::ASSERT;
     keyword[UStr::create("break")] = TokenKind::BREAK;
@@ -127,6 +131,11 @@ TokenKind
 getToken()
 {
     lastToken = token;
+    if (nextToken) {
+	token = *nextToken;
+	nextToken.reset();
+	return token.kind;
+    }
     do {
 	while (true) {
 	    if (macro::hasToken()) {
@@ -149,6 +158,19 @@ getToken()
     return token.kind;
 }
 
+const Token &
+peekToken()
+{
+    if (!nextToken) {
+	auto current = token, last = lastToken;
+	getToken();
+	nextToken = token;
+	token = current;
+	lastToken = last;
+    }
+    return *nextToken;
+}
+
 TokenKind
 getToken_(bool skipNewline)
 {
@@ -168,7 +190,9 @@ getToken_(bool skipNewline)
 	std::string str{char(parseCharacterLiteral())};
 	return setToken(TokenKind::CHARACTER_LITERAL, str);
     } else if (reader->ch == '@') {
-	parseAddDirective();
+	if (parseAddDirective()) {
+	    return token.kind;
+	}
 	return getToken();
     } else if (isLetter(reader->ch)) {
 	while (isLetter(reader->ch) || isDecDigit(reader->ch)) {
@@ -713,9 +737,19 @@ parseCharacterLiteral()
     return val;
 }
 
-static void
+// Returns true if the directive is a pragma. In this case the pragma is the
+// current token and gets handled by the parser.
+static bool
 parseAddDirective()
 {
+    static const std::set<UStr> pragma = {
+	UStr::create("unroll"),
+	UStr::create("nounroll"),
+	UStr::create("vectorize"),
+	UStr::create("interleave"),
+	UStr::create("target_clones"),
+    };
+
     auto ifdefKw = UStr::create("ifdef");
     auto endifKw = UStr::create("endif");
     auto defineKw = UStr::create("define");
@@ -723,7 +757,10 @@ parseAddDirective()
     // ch == '@'
     nextCh();
     getToken_();
-    if (token.kind == TokenKind::IDENTIFIER && token.val == ifdefKw) {
+    if (token.kind == TokenKind::IDENTIFIER && pragma.contains(token.val)) {
+	token = Token(token.loc, TokenKind::PRAGMA, token.val);
+	return true;
+    } else if (token.kind == TokenKind::IDENTIFIER && token.val == ifdefKw) {
 	getToken_(false);
 	if (token.kind != TokenKind::IDENTIFIER) {
 	    error::out() << token.loc << ": expected identifier" << std::endl;
@@ -758,10 +795,10 @@ parseAddDirective()
 
     } else if (token.kind == TokenKind::STRING_LITERAL) {
 	if (macro::ignoreToken()) {
-	    return;
+	    return false;
 	}
 	if (includedFiles_.contains(token.processedVal.c_str())) {
-	    return;
+	    return false;
 	}
 	if (!openInputfile(token.processedVal.c_str())) {
 	    error::out() << token.loc << ": can not open file " << token.val
@@ -783,7 +820,7 @@ parseAddDirective()
 	    error::fatal();
 	}
 	if (macro::ignoreToken() || includedFiles_.contains(path)) {
-	    return;
+	    return false;
 	}
 	includedFiles_.insert(path);
 	if (!openInputfile(path)) {
@@ -796,6 +833,7 @@ parseAddDirective()
 	             << std::endl;
 	error::fatal();
     }
+    return false;
 }
 
 static void
@@ -17,6 +17,10 @@ extern Token token, lastToken;
 
 TokenKind getToken();
 
+// Returns the token following 'token' without consuming it. Used for words
+// that are only keywords in some context, e.g. "return tail f();"
+const Token &peekToken();
+
 } // namespace lexer
 } // namespace abc
 
@@ -1,6 +1,8 @@
 #include <cassert>
 #include <cstdlib>
 #include <iostream>
+#include <string>
+#include <unordered_map>
 
 #include "reader.hpp"
 #include "util/ustr.hpp"
@@ -43,6 +45,8 @@ ReaderInfo::resetStart()
 std::unique_ptr<ReaderInfo> reader;
 static std::vector<std::unique_ptr<ReaderInfo>> openReader;
 static std::vector<std::filesystem::path> searchPath;
+// results of searchFile() for the current search path
+static std::unordered_map<std::string, std::filesystem::path> searchResult;
 
 // read next character and update reader
 char
@@ -76,14 +80,20 @@ nextCh()
 std::filesystem::path
 searchFile(std::filesystem::path path)
 {
+    auto found = searchResult.find(path.string());
+    if (found != searchResult.end()) {
+	return found->second;
+    }
+    auto &result = searchResult[path.string()];
     for (auto sp : searchPath) {
 	sp /= path;
 	std::ifstream f(sp.c_str());
 	if (f.good()) {
-	    return sp;
+	    result = sp;
+	    break;
 	}
     }
-    return "";
+    return result;
 }
 
 // if path is nullptr read from stdin
@@ -108,6 +118,7 @@ void
 addSearchPath(std::filesystem::path path)
 {
     searchPath.push_back(path);
+    searchResult.clear();
 }
 
 const std::vector<std::filesystem::path> &
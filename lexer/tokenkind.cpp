@@ -30,7 +30,11 @@ TokenKindCStr(TokenKind kind)
 	return "FLOAT_DECIMAL_LITERAL";
     case TokenKind::FLOAT_HEXADECIMAL_LITERAL:
 	return "FLOAT_HEXADECIMAL_LITERAL";
+    case TokenKind::PRAGMA:
+	return "PRAGMA";
 
+    case TokenKind::ALIGNAS:
+	return "ALIGNAS";
     case TokenKind::ARRAY:
 	return "ARRAY";
     case TokenKind::ASSERT:
@@ -189,6 +193,8 @@ static const char *
 getCStr(TokenKind kind)
 {
     switch (kind) {
+    case TokenKind::ALIGNAS:
+	return "alignas";
     case TokenKind::ARRAY:
 	return "array";
     case TokenKind::ASSERT:
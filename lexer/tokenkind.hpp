@@ -21,6 +21,9 @@ enum class TokenKind
     FLOAT_DECIMAL_LITERAL,
     FLOAT_HEXADECIMAL_LITERAL,
 
+    // directives that are passed to the parser, e.g. '@unroll'
+    PRAGMA,
+
     // keywords
     ASSERT,
     GOTO,
@@ -44,6 +47,7 @@ enum class TokenKind
     NULLPTR,
     STRUCT,
     UNION,
+    ALIGNAS,
     TYPE,
     BREAK,
     CONTINUE,
@@ -1,5 +1,10 @@
 #include "expr/assertexpr.hpp"
+#include "expr/builtinexpr.hpp"
+#include "expr/enumconstant.hpp"
+#include "gen/atomic.hpp"
 #include "gen/function.hpp"
+#include "symtab/symtab.hpp"
+#include "type/enumtype.hpp"
 #include "type/functiontype.hpp"
 #include "type/integertype.hpp"
 #include "type/pointertype.hpp"
@@ -8,9 +13,46 @@
 
 namespace abc {
 
+static void
+initMemoryOrder()
+{
+    static std::vector<ExprPtr> memoryOrderConstant;
+    memoryOrderConstant.clear();
+
+    const std::pair<const char *, gen::AtomicOrdering> memoryOrder[] = {
+        {"memory_order_relaxed", gen::RELAXED},
+        {"memory_order_acquire", gen::ACQUIRE},
+        {"memory_order_release", gen::RELEASE},
+        {"memory_order_acq_rel", gen::ACQ_REL},
+        {"memory_order_seq_cst", gen::SEQ_CST},
+    };
+
+    auto name = UStr::create("memory_order");
+    auto enumType = EnumType::createIncomplete(name, IntegerType::createInt());
+    Symtab::addType(lexer::Loc{}, name, enumType).first->setPredefinedFlag();
+
+    std::vector<UStr> constName;
+    std::vector<std::int64_t> constValue;
+    for (const auto &[str, val] : memoryOrder) {
+	auto ecName = UStr::create(str);
+	auto ec = EnumConstant::create(ecName, val, enumType, lexer::Loc{});
+	Symtab::addExpression(lexer::Loc{}, ecName, ec.get())
+	    .first->setPredefinedFlag();
+	memoryOrderConstant.push_back(std::move(ec));
+	constName.push_back(ecName);
+	constValue.push_back(val);
+    }
+    enumType->complete(std::move(constName), std::move(constValue));
+}
+
 void
 initDefaultDecl()
 {
+    for (auto name : BuiltinExpr::nameList()) {
+	Symtab::addBuiltin(lexer::Loc{}, name);
+    }
+    initMemoryOrder();
+
     std::vector<const Type *> param;
     param.push_back(PointerType::create(IntegerType::createChar()));
     param.push_back(PointerType::create(IntegerType::createChar()));
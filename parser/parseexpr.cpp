@@ -1,5 +1,6 @@
 #include "expr/assertexpr.hpp"
 #include "expr/binaryexpr.hpp"
+#include "expr/builtinexpr.hpp"
 #include "expr/callexpr.hpp"
 #include "expr/characterliteral.hpp"
 #include "expr/compoundexpr.hpp"
@@ -10,6 +11,7 @@
 #include "expr/floatliteral.hpp"
 #include "expr/identifier.hpp"
 #include "expr/integerliteral.hpp"
+#include "expr/labeladdress.hpp"
 #include "expr/member.hpp"
 #include "expr/nullptr.hpp"
 #include "expr/sizeof.hpp"
@@ -476,6 +478,15 @@ parsePrefix()
     case TokenKind::AND:
 	getToken();
 	return UnaryExpr::create(UnaryExpr::ADDRESS, parsePrefix(), tok.loc);
+    case TokenKind::AND2:
+	// address of a label
+	getToken();
+	if (!error::expected(TokenKind::IDENTIFIER)) {
+	    return nullptr;
+	}
+	tok = token;
+	getToken();
+	return LabelAddress::create(tok.val, tok.loc);
     case TokenKind::ASTERISK:
 	getToken();
 	return UnaryExpr::create(UnaryExpr::ASTERISK_DEREF, parsePrefix(),
@@ -636,9 +647,30 @@ parsePrimary()
 	        EnumConstant::create(tok.val, sym->expr->getSignedIntValue(),
 	                             sym->expr->type, tok.loc);
 	    return expr;
+	} else if (auto sym = Symtab::builtin(tok.val, Symtab::AnyScope)) {
+	    // builtins are not first class objects and have to be called
+	    if (!error::expected(TokenKind::LPAREN)) {
+		return nullptr;
+	    }
+	    getToken();
+	    std::vector<ExprPtr> arg;
+	    while (auto a = parseAssignmentExpression()) {
+		arg.push_back(std::move(a));
+		if (token.kind != TokenKind::COMMA) {
+		    break;
+		}
+		getToken();
+	    }
+	    if (!error::expected(TokenKind::RPAREN)) {
+		return nullptr;
+	    }
+	    getToken();
+	    return BuiltinExpr::create(sym->getId(), std::move(arg), tok.loc);
 	} else if (auto sym = Symtab::variable(tok.val, Symtab::AnyScope)) {
 	    auto ty = sym->type;
-	    auto hasLinkage = sym->hasLinkage();
+	    // the address of a thread-local variable is not a link-time
+	    // constant
+	    auto hasLinkage = sym->hasLinkage() && !sym->isThreadLocal();
 	    auto expr = Identifier::create(tok.val, sym->getId(), ty,
 	                                   hasLinkage, tok.loc);
 	    return expr;
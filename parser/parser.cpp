@@ -1,7 +1,9 @@
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <stack>
 
+#include "expr/callexpr.hpp"
 #include "expr/compoundexpr.hpp"
 #include "expr/expr.hpp"
 #include "lexer/error.hpp"
@@ -52,17 +54,16 @@ static AstPtr parseTopLevelDeclaration();
 /*
  * input-sequence = {top-level-declaration} EOI
  */
-AstPtr
-parser()
+static bool
+parseInputSequence(const std::function<void(AstPtr &&)> &append)
 {
     Symtab newScope;
     initDefaultType();
     initDefaultDecl();
     getToken();
 
-    auto top = std::make_unique<AstList>();
     while (auto decl = parseTopLevelDeclaration()) {
-	top->append(std::move(decl));
+	append(std::move(decl));
     }
     if (token.kind != TokenKind::EOI) {
 	error::location(token.loc);
@@ -71,13 +72,41 @@ parser()
 	             << "error: " << error::setColor(error::BOLD)
 	             << "unexpected " << token.val.c_str() << "\n"
 	             << error::setColor(error::NORMAL);
-	return nullptr;
+	return false;
     }
     getToken();
+    return true;
+}
+
+AstPtr
+parser()
+{
+    auto top = std::make_unique<AstList>();
+    auto append = [&top](AstPtr &&decl) { top->append(std::move(decl)); };
+    if (!parseInputSequence(append)) {
+	return nullptr;
+    }
     return top;
 }
 
+bool
+parser(const std::function<void(std::shared_ptr<Ast>)> &handle)
+{
+    // enum constants in the symbol table refer to expressions of their
+    // declaration, so these are kept until the end of the scope
+    std::vector<std::shared_ptr<Ast>> keep;
+    auto append = [&](AstPtr &&ast) {
+	std::shared_ptr<Ast> decl = std::move(ast);
+	if (dynamic_cast<AstEnumDecl *>(decl.get())) {
+	    keep.push_back(decl);
+	}
+	handle(std::move(decl));
+    };
+    return parseInputSequence(append);
+}
+
 //------------------------------------------------------------------------------
+static AstPtr parseAnnotatedFunctionDefinition();
 static AstPtr parseFunctionDeclarationOrDefinition();
 static AstPtr parseExternDeclaration();
 static AstPtr parseGlobalVariableDefinition();
@@ -86,7 +115,8 @@ static AstPtr parseStructDeclaration();
 static AstPtr parseEnumDeclaration();
 
 /*
- * top-level-declaration = function-declaration-or-definition
+ * top-level-declaration = annotated-function-definition
+ *			 | function-declaration-or-definition
  *			 | extern-declaration
  *			 | global-variable-definition
  *			 | type-declaration
@@ -98,7 +128,8 @@ parseTopLevelDeclaration()
 {
     AstPtr ast;
 
-    (ast = parseFunctionDeclarationOrDefinition()) ||
+    (ast = parseAnnotatedFunctionDefinition()) ||
+        (ast = parseFunctionDeclarationOrDefinition()) ||
         (ast = parseExternDeclaration()) ||
         (ast = parseGlobalVariableDefinition()) ||
         (ast = parseTypeDeclaration()) || (ast = parseEnumDeclaration()) ||
@@ -107,6 +138,88 @@ parseTopLevelDeclaration()
     return ast;
 }
 
+//------------------------------------------------------------------------------
+static bool parseTargetClones(std::vector<std::string> &targetClones);
+
+/*
+ * annotated-function-definition
+ *	= function-pragma function-header function-body
+ * function-pragma
+ *	= "@target_clones" "(" string-literal { "," string-literal } ")"
+ */
+static AstPtr
+parseAnnotatedFunctionDefinition()
+{
+    if (token.kind != TokenKind::PRAGMA) {
+	return nullptr;
+    }
+    if (token.val != UStr::create("target_clones")) {
+	error::location(token.loc);
+	error::out() << error::setColor(error::BOLD) << token.loc << ": "
+	             << error::setColor(error::BOLD_RED)
+	             << "error: " << error::setColor(error::BOLD) << "'@"
+	             << token.val.c_str() << "' is not a function pragma\n"
+	             << error::setColor(error::NORMAL);
+	error::fatal();
+	return nullptr;
+    }
+
+    std::vector<std::string> targetClones;
+    if (!parseTargetClones(targetClones)) {
+	return nullptr;
+    }
+
+    auto loc = token.loc;
+    auto ast = parseFunctionDeclarationOrDefinition();
+    auto fnDef = dynamic_cast<AstFuncDef *>(ast.get());
+    if (!fnDef) {
+	error::location(loc);
+	error::out() << error::setColor(error::BOLD) << loc << ": "
+	             << error::setColor(error::BOLD_RED)
+	             << "error: " << error::setColor(error::BOLD)
+	             << "function definition expected after function pragma\n"
+	             << error::setColor(error::NORMAL);
+	error::fatal();
+	return nullptr;
+    }
+    fnDef->targetClones = std::move(targetClones);
+    return ast;
+}
+
+static bool
+parseTargetClones(std::vector<std::string> &targetClones)
+{
+    auto pragmaLoc = token.loc;
+    getToken();
+    if (!error::expected(TokenKind::LPAREN)) {
+	return false;
+    }
+    do {
+	getToken();
+	if (!error::expected(TokenKind::STRING_LITERAL)) {
+	    return false;
+	}
+	targetClones.push_back(token.processedVal.c_str());
+	getToken();
+    } while (token.kind == TokenKind::COMMA);
+    if (!error::expected(TokenKind::RPAREN)) {
+	return false;
+    }
+    getToken();
+
+    if (std::ranges::find(targetClones, "default") == targetClones.end()) {
+	error::location(pragmaLoc);
+	error::out() << error::setColor(error::BOLD) << pragmaLoc << ": "
+	             << error::setColor(error::BOLD_RED)
+	             << "error: " << error::setColor(error::BOLD)
+	             << "'@target_clones' requires a \"default\" version\n"
+	             << error::setColor(error::NORMAL);
+	error::fatal();
+	return false;
+    }
+    return true;
+}
+
 //------------------------------------------------------------------------------
 static const Type *parseFunctionHeader(Token &fnName,
                                        std::vector<Token> &fnParamName);
@@ -318,9 +431,27 @@ static const Type *parseFunctionDeclaration(Token &fnIdent,
 
 static AstListPtr parseExternVariableDeclaration();
 
+/*
+ * 'thread' is only a keyword if the name of a variable follows, e.g. in
+ * "global thread counter: int;", so "global thread: int;" still defines a
+ * variable named 'thread'
+ */
+static bool
+parseThreadQualifier()
+{
+    if (token.kind != TokenKind::IDENTIFIER ||
+        token.val != UStr::create("thread") ||
+        peekToken().kind != TokenKind::IDENTIFIER) {
+	return false;
+    }
+    getToken();
+    return true;
+}
+
 /*
  * extern-declaration
- *	= "extern" ( function-declaration | extern-variable-declaration ) ";"
+ *	= "extern" ( function-declaration
+ *		   | ["thread"] extern-variable-declaration ) ";"
  */
 static AstPtr
 parseExternDeclaration()
@@ -330,9 +461,12 @@ parseExternDeclaration()
     }
     getToken();
 
+    bool threadLocal = parseThreadQualifier();
+
     Token fnIdent;
     std::vector<Token> fnParamName;
-    auto fnType = parseFunctionDeclaration(fnIdent, fnParamName);
+    auto fnType =
+        threadLocal ? nullptr : parseFunctionDeclaration(fnIdent, fnParamName);
     auto varDecl = parseExternVariableDeclaration();
 
     if (!fnType && !varDecl) {
@@ -353,7 +487,7 @@ parseExternDeclaration()
 	return std::make_unique<AstFuncDecl>(fnIdent, fnType,
 	                                     std::move(fnParamName), true);
     } else if (varDecl) {
-	return std::make_unique<AstExternVar>(std::move(varDecl));
+	return std::make_unique<AstExternVar>(std::move(varDecl), threadLocal);
     }
     assert(0);
     return nullptr;
@@ -548,7 +682,7 @@ parseIdentifierList(std::vector<Token> &identifier)
 static AstListPtr parseVariableDefinitionList();
 
 /*
- * global-variable-definition = "global" variable-definition-list ";"
+ * global-variable-definition = "global" ["thread"] variable-definition-list ";"
  */
 static AstPtr
 parseGlobalVariableDefinition()
@@ -557,6 +691,7 @@ parseGlobalVariableDefinition()
 	return nullptr;
     }
     getToken();
+    bool threadLocal = parseThreadQualifier();
     auto def = parseVariableDefinitionList();
     if (!def) {
 	error::location(token.loc);
@@ -572,13 +707,13 @@ parseGlobalVariableDefinition()
 	return nullptr;
     }
     getToken();
-    return std::make_unique<AstGlobalVar>(std::move(def));
+    return std::make_unique<AstGlobalVar>(std::move(def), threadLocal);
 }
 
 //------------------------------------------------------------------------------
 
 /*
- * static-variable-definition = "static" variable-definition-list ";"
+ * static-variable-definition = "static" ["thread"] variable-definition-list ";"
  */
 static AstPtr
 parseStaticVariableDefinition()
@@ -587,6 +722,7 @@ parseStaticVariableDefinition()
 	return nullptr;
     }
     getToken();
+    bool threadLocal = parseThreadQualifier();
     auto def = parseVariableDefinitionList();
     if (!def) {
 	error::location(token.loc);
@@ -602,7 +738,7 @@ parseStaticVariableDefinition()
 	return nullptr;
     }
     getToken();
-    return std::make_unique<AstStaticVar>(std::move(def));
+    return std::make_unique<AstStaticVar>(std::move(def), threadLocal);
 }
 
 //------------------------------------------------------------------------------
@@ -639,11 +775,56 @@ parseVariableDefinitionList()
     return astList;
 }
 
+//------------------------------------------------------------------------------
+/*
+ * alignment-specifier = "alignas" "(" assignment-expression ")"
+ */
+static std::size_t
+parseAlignmentSpecifier()
+{
+    if (token.kind != TokenKind::ALIGNAS) {
+	return 0;
+    }
+    getToken();
+    if (!error::expected(TokenKind::LPAREN)) {
+	return 0;
+    }
+    getToken();
+    auto loc = token.loc;
+    auto expr = parseAssignmentExpression();
+    if (!expr || !expr->isConst() || !expr->type->isInteger()) {
+	error::location(loc);
+	error::out() << error::setColor(error::BOLD) << loc << ": "
+	             << error::setColor(error::BOLD_RED)
+	             << "error: " << error::setColor(error::BOLD)
+	             << "constant integer expression expected for alignment\n"
+	             << error::setColor(error::NORMAL);
+	error::fatal();
+	return 0;
+    }
+    auto alignment = expr->getSignedIntValue();
+    if (alignment <= 0 || (alignment & (alignment - 1))) {
+	error::location(loc);
+	error::out() << error::setColor(error::BOLD) << loc << ": "
+	             << error::setColor(error::BOLD_RED)
+	             << "error: " << error::setColor(error::BOLD)
+	             << "alignment has to be a power of two\n"
+	             << error::setColor(error::NORMAL);
+	error::fatal();
+	return 0;
+    }
+    if (!error::expected(TokenKind::RPAREN)) {
+	return 0;
+    }
+    getToken();
+    return alignment;
+}
+
 //------------------------------------------------------------------------------
 static AstInitializerExprPtr parseInitializerExpression(const Type *type);
 
 /*
- * variable-definition = identifier-list ":" type
+ * variable-definition = identifier-list ":" type [ alignment-specifier ]
  *			  [ "=" initializer-expression ]
  */
 static AstVarPtr
@@ -680,6 +861,7 @@ parseVariableDefinition()
     bool define = !varType->isUnboundArray() && !varType->isAuto();
     auto astVar = std::make_unique<AstVar>(std::move(varName), varTypeLoc,
                                            varType, define);
+    astVar->setAlignment(parseAlignmentSpecifier());
     if (varType->isUnboundArray() && token.kind != TokenKind::EQUAL) {
 	error::location(token.loc);
 	error::out() << error::setColor(error::BOLD) << token.loc << ": "
@@ -747,7 +929,7 @@ parseInitializerExpression(const Type *type)
 	    assert(compExpr);
 	    bool ok = true;
 	    for (std::size_t i = 0; i < type->dim(); ++i) {
-		if (!compExpr->expr[i]) {
+		if (!compExpr->element(i)) {
 		    ok = false;
 		    break;
 		}
@@ -829,6 +1011,7 @@ static AstPtr parseSwitchStatement();
 static AstPtr parseWhileStatement();
 static AstPtr parseDoWhileStatement();
 static AstPtr parseForStatement();
+static AstPtr parseAnnotatedLoopStatement();
 static AstPtr parseReturnStatement();
 static AstPtr parseBreakStatement();
 static AstPtr parseContinueStatement();
@@ -843,6 +1026,7 @@ static AstPtr parseExpressionStatement();
  *	     | while-statement
  *	     | do-while-statement
  *	     | for-statement
+ *	     | annotated-loop-statement
  *	     | return-statement
  *	     | break-statement
  *	     | continue-statement
@@ -858,6 +1042,7 @@ parseStatement()
     (ast = parseCompoundStatement()) || (ast = parseIfStatement()) ||
         (ast = parseSwitchStatement()) || (ast = parseWhileStatement()) ||
         (ast = parseDoWhileStatement()) || (ast = parseForStatement()) ||
+        (ast = parseAnnotatedLoopStatement()) ||
         (ast = parseReturnStatement()) || (ast = parseBreakStatement()) ||
         (ast = parseContinueStatement()) || (ast = parseGotoStatement()) ||
         (ast = parseLabelDefinition()) || (ast = parseExpressionStatement());
@@ -960,7 +1145,8 @@ parseIfStatement()
 /*
  * switch-statement = "switch" "(" expression-list ")"
  *			"{" switch-case-or-statement "}"
- * switch-case-or-statement = "case" expression-list ":"
+ * switch-case-or-statement = "case" expression-list
+ *				  [ "..." expression-list ] ":"
  *			    | "default" ":"
  *			    | statement
  */
@@ -1011,11 +1197,26 @@ parseSwitchStatement()
 		             << error::setColor(error::NORMAL);
 		error::fatal();
 	    }
+	    ExprPtr lastExpr;
+	    if (token.kind == TokenKind::DOT3) {
+		// case range
+		getToken();
+		lastExpr = parseExpressionList();
+		if (!lastExpr) {
+		    error::location(token.loc);
+		    error::out() << error::setColor(error::BOLD) << token.loc
+		                 << ": " << error::setColor(error::BOLD_RED)
+		                 << "error: " << error::setColor(error::BOLD)
+		                 << "expression expected\n"
+		                 << error::setColor(error::NORMAL);
+		    error::fatal();
+		}
+	    }
 	    if (!error::expected(TokenKind::COLON)) {
 		return nullptr;
 	    }
 	    getToken();
-	    switchStmt->appendCase(std::move(expr));
+	    switchStmt->appendCase(std::move(expr), std::move(lastExpr));
 	} else if (token.kind == TokenKind::DEFAULT) {
 	    getToken();
 	    if (!error::expected(TokenKind::COLON)) {
@@ -1199,7 +1400,114 @@ parseForStatement()
 
 //------------------------------------------------------------------------------
 /*
- * return-statement = "return" [ expression ] ";"
+ * loop-pragma-argument = "(" assignment-expression ")"
+ */
+static unsigned
+parseLoopPragmaArgument(bool required)
+{
+    auto pragma = token;
+    getToken();
+    if (!required && token.kind != TokenKind::LPAREN) {
+	return 0;
+    }
+    if (!error::expected(TokenKind::LPAREN)) {
+	return 0;
+    }
+    getToken();
+    auto loc = token.loc;
+    auto expr = parseAssignmentExpression();
+    if (!expr || !expr->isConst() || !expr->type->isInteger() ||
+        expr->getSignedIntValue() <= 0) {
+	error::location(loc);
+	error::out() << error::setColor(error::BOLD) << loc << ": "
+	             << error::setColor(error::BOLD_RED)
+	             << "error: " << error::setColor(error::BOLD)
+	             << "positive constant integer expression expected for '@"
+	             << pragma.val << "'\n"
+	             << error::setColor(error::NORMAL);
+	error::fatal();
+	return 0;
+    }
+    if (!error::expected(TokenKind::RPAREN)) {
+	return 0;
+    }
+    getToken();
+    return expr->getUnsignedIntValue();
+}
+
+/*
+ * annotated-loop-statement = loop-pragma { loop-pragma }
+ *			      ( while-statement
+ *			      | do-while-statement
+ *			      | for-statement )
+ * loop-pragma = "@unroll" [ loop-pragma-argument ]
+ *	       | "@nounroll"
+ *	       | "@vectorize" loop-pragma-argument
+ *	       | "@interleave" loop-pragma-argument
+ */
+static AstPtr
+parseAnnotatedLoopStatement()
+{
+    if (token.kind != TokenKind::PRAGMA) {
+	return nullptr;
+    }
+
+    gen::LoopHint loopHint;
+    while (token.kind == TokenKind::PRAGMA) {
+	if (token.val == UStr::create("unroll")) {
+	    loopHint.unrollCount = parseLoopPragmaArgument(false);
+	    loopHint.unrollFull = !loopHint.unrollCount;
+	} else if (token.val == UStr::create("nounroll")) {
+	    loopHint.noUnroll = true;
+	    getToken();
+	} else if (token.val == UStr::create("vectorize")) {
+	    loopHint.vectorizeWidth = parseLoopPragmaArgument(true);
+	} else if (token.val == UStr::create("interleave")) {
+	    loopHint.interleaveCount = parseLoopPragmaArgument(true);
+	} else {
+	    error::location(token.loc);
+	    error::out() << error::setColor(error::BOLD) << token.loc << ": "
+	                 << error::setColor(error::BOLD_RED)
+	                 << "error: " << error::setColor(error::BOLD) << "'@"
+	                 << token.val.c_str() << "' is not a loop pragma\n"
+	                 << error::setColor(error::NORMAL);
+	    error::fatal();
+	    return nullptr;
+	}
+    }
+    if (loopHint.noUnroll && (loopHint.unrollFull || loopHint.unrollCount)) {
+	error::location(token.loc);
+	error::out() << error::setColor(error::BOLD) << token.loc << ": "
+	             << error::setColor(error::BOLD_RED)
+	             << "error: " << error::setColor(error::BOLD)
+	             << "'@nounroll' conflicts with '@unroll'\n"
+	             << error::setColor(error::NORMAL);
+	error::fatal();
+	return nullptr;
+    }
+
+    AstPtr loop;
+    (loop = parseWhileStatement()) || (loop = parseDoWhileStatement()) ||
+        (loop = parseForStatement());
+    if (!loop) {
+	error::location(token.loc);
+	error::out() << error::setColor(error::BOLD) << token.loc << ": "
+	             << error::setColor(error::BOLD_RED)
+	             << "error: " << error::setColor(error::BOLD)
+	             << "loop statement expected after loop pragma\n"
+	             << error::setColor(error::NORMAL);
+	error::fatal();
+	return nullptr;
+    }
+    auto annotatedLoop = dynamic_cast<AstLoop *>(loop.get());
+    assert(annotatedLoop);
+    annotatedLoop->loopHint = loopHint;
+    return loop;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * return-statement = "return" [ [ "tail" ] expression ] ";"
  */
 static AstPtr
 parseReturnStatement()
@@ -1209,12 +1517,31 @@ parseReturnStatement()
     }
     auto tok = token;
     getToken();
+    // 'tail' is only a keyword if a function name follows, otherwise it is
+    // an ordinary identifier, e.g. in "return tail;" or "return tail(x);"
+    bool tailCall = token.kind == TokenKind::IDENTIFIER &&
+                    token.val == UStr::create("tail") &&
+                    peekToken().kind == TokenKind::IDENTIFIER;
+    if (tailCall) {
+	getToken();
+    }
+    auto exprLoc = token.loc;
     auto expr = parseExpressionList();
+    if (tailCall && !dynamic_cast<const CallExpr *>(expr.get())) {
+	error::location(exprLoc);
+	error::out() << error::setColor(error::BOLD) << exprLoc << ": "
+	             << error::setColor(error::BOLD_RED)
+	             << "error: " << error::setColor(error::BOLD)
+	             << "function call expected after 'return tail'\n"
+	             << error::setColor(error::NORMAL);
+	error::fatal();
+	return nullptr;
+    }
     if (!error::expected(TokenKind::SEMICOLON)) {
 	return nullptr;
     }
     getToken();
-    return std::make_unique<AstReturn>(tok.loc, std::move(expr));
+    return std::make_unique<AstReturn>(tok.loc, std::move(expr), tailCall);
 }
 
 //------------------------------------------------------------------------------
@@ -1256,7 +1583,7 @@ parseContinueStatement()
 
 //------------------------------------------------------------------------------
 /*
- * goto-statement = "goto" identifier ";"
+ * goto-statement = "goto" ( identifier | "*" expression ) ";"
  */
 static AstPtr
 parseGotoStatement()
@@ -1265,6 +1592,27 @@ parseGotoStatement()
 	return nullptr;
     }
     getToken();
+    if (token.kind == TokenKind::ASTERISK) {
+	// computed goto
+	auto loc = token.loc;
+	getToken();
+	auto expr = parseExpressionList();
+	if (!expr) {
+	    error::location(token.loc);
+	    error::out() << error::setColor(error::BOLD) << token.loc << ": "
+	                 << error::setColor(error::BOLD_RED)
+	                 << "error: " << error::setColor(error::BOLD)
+	                 << "expression expected\n"
+	                 << error::setColor(error::NORMAL);
+	    error::fatal();
+	    return nullptr;
+	}
+	if (!error::expected(TokenKind::SEMICOLON)) {
+	    return nullptr;
+	}
+	getToken();
+	return std::make_unique<AstGoto>(loc, std::move(expr));
+    }
     auto label = token;
     if (!error::expectedAfterLastToken(TokenKind::IDENTIFIER)) {
 	return nullptr;
@@ -1495,7 +1843,9 @@ parseEnumConstantList(AstEnumDeclPtr &enumDecl)
 static bool parseStructMemberDeclaration(AstStructDecl *structDecl);
 
 /*
- * struct-declaration = "struct" identifier (";" | struct-member-declaration )
+ * struct-declaration = "struct" identifier
+ *			( ";" | ["packed"] [alignment-specifier]
+ *			  struct-member-declaration )
  */
 static AstPtr
 parseStructDeclaration()
@@ -1512,10 +1862,18 @@ parseStructDeclaration()
 
     auto structDecl = std::make_unique<AstStructDecl>(structTypeName);
 
-    if (token.kind == TokenKind::SEMICOLON) {
+    // 'packed' is only a keyword here, no identifier can follow the name
+    bool packed = token.kind == TokenKind::IDENTIFIER &&
+                  token.val == UStr::create("packed");
+    if (packed) {
+	getToken();
+    }
+    auto alignment = parseAlignmentSpecifier();
+
+    if (token.kind == TokenKind::SEMICOLON && !packed && !alignment) {
 	getToken();
     } else if (parseStructMemberDeclaration(structDecl.get())) {
-	structDecl->complete();
+	structDecl->complete(packed, alignment);
     } else {
 	error::location(token.loc);
 	error::out() << error::setColor(error::BOLD) << token.loc << ": "
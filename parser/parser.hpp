@@ -1,11 +1,18 @@
 #ifndef PARSER_PARSER_HPP
 #define PARSER_PARSER_HPP
 
+#include <functional>
+#include <memory>
+
 #include "ast/ast.hpp"
 
 namespace abc {
 
 AstPtr parser();
+// Streaming mode: each top-level declaration is passed to 'handle' as soon as
+// it is parsed. It gets released when 'handle' and the parser drop it. Returns
+// false on a syntax error.
+bool parser(const std::function<void(std::shared_ptr<Ast>)> &handle);
 const Type *parseType(bool allowZeroDim = false);
 
 } // namespace abc
@@ -33,6 +33,12 @@ Entry::createExprEntry(lexer::Loc loc, UStr id, const Expr *expr)
     return Entry(loc, id, expr);
 }
 
+Entry
+Entry::createBuiltinEntry(lexer::Loc loc, UStr id)
+{
+    return Entry(BUILTIN, loc, id, nullptr);
+}
+
 const UStr
 Entry::getId() const
 {
@@ -57,6 +63,12 @@ Entry::expressionDeclaration() const
     return kind == EXPR;
 }
 
+bool
+Entry::builtinDeclaration() const
+{
+    return kind == BUILTIN;
+}
+
 bool
 Entry::setDefinitionFlag()
 {
@@ -68,6 +80,18 @@ Entry::setDefinitionFlag()
     return true;
 }
 
+void
+Entry::setPredefinedFlag()
+{
+    predefinedFlag = true;
+}
+
+bool
+Entry::predefined() const
+{
+    return predefinedFlag;
+}
+
 bool
 Entry::setExternalLinkage()
 {
@@ -111,6 +135,25 @@ Entry::hasLinkage() const
     return linkage != NO_LINKAGE;
 }
 
+bool
+Entry::setThreadLocal(bool threadLocal)
+{
+    assert(variableDeclaration());
+    auto storage = threadLocal ? THREAD_STORAGE : STATIC_STORAGE;
+    // all declarations of a variable must agree on thread storage
+    if (storageDuration != UNSPECIFIED_STORAGE && storageDuration != storage) {
+	return false;
+    }
+    storageDuration = storage;
+    return true;
+}
+
+bool
+Entry::isThreadLocal() const
+{
+    return storageDuration == THREAD_STORAGE;
+}
+
 bool
 operator!=(const Entry &a, const Entry &b)
 {
@@ -123,6 +166,9 @@ operator!=(const Entry &a, const Entry &b)
     if (a.kind == Entry::EXPR) {
 	return a.expr != b.expr;
     }
+    if (a.kind == Entry::BUILTIN) {
+	return a.id != b.id;
+    }
     assert(0);
     return false;
 }
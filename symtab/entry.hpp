@@ -16,6 +16,7 @@ class Entry
 	    VAR,
 	    TYPE,
 	    EXPR,
+	    BUILTIN,
 	};
 
 	enum Linkage
@@ -25,17 +26,29 @@ class Entry
 	    INTERNAL_LINKAGE,
 	};
 
+	enum StorageDuration
+	{
+	    UNSPECIFIED_STORAGE,
+	    STATIC_STORAGE,
+	    THREAD_STORAGE,
+	};
+
 	Entry(Kind kind, lexer::Loc loc, UStr id, const Type *type);
 	Entry(lexer::Loc loc, UStr id, const Expr *expr);
 
 	bool definitionFlag = false;
+	// builtins and predefined constants can be shadowed by user
+	// declarations in the global scope
+	bool predefinedFlag = false;
 	Linkage linkage = NO_LINKAGE;
+	StorageDuration storageDuration = UNSPECIFIED_STORAGE;
 	UStr id;
 
     public:
 	static Entry createVarEntry(lexer::Loc loc, UStr id, const Type *type);
 	static Entry createTypeEntry(lexer::Loc loc, UStr id, const Type *type);
 	static Entry createExprEntry(lexer::Loc loc, UStr id, const Expr *expr);
+	static Entry createBuiltinEntry(lexer::Loc loc, UStr id);
 
 	const Kind kind;
 	const lexer::Loc loc;
@@ -48,12 +61,17 @@ class Entry
 	bool typeDeclaration() const;
 	bool variableDeclaration() const;
 	bool expressionDeclaration() const;
+	bool builtinDeclaration() const;
 
 	bool setDefinitionFlag();
+	void setPredefinedFlag();
+	bool predefined() const;
 	bool setExternalLinkage();
 	bool setInternalLinkage();
 	bool setLinkage();
 	bool hasLinkage() const;
+	bool setThreadLocal(bool threadLocal);
+	bool isThreadLocal() const;
 
 	friend bool operator!=(const Entry &a, const Entry &b);
 };
@@ -102,6 +102,16 @@ Symtab::constant(UStr name, Scope inScope)
     return nullptr;
 }
 
+const symtab::Entry *
+Symtab::builtin(UStr name, Scope inScope)
+{
+    auto entry = find(name, inScope);
+    if (entry && entry->builtinDeclaration()) {
+	return entry;
+    }
+    return nullptr;
+}
+
 std::pair<symtab::Entry *, bool>
 Symtab::addDeclaration(lexer::Loc loc, UStr name, const Type *type)
 {
@@ -146,6 +156,15 @@ Symtab::addExpression(lexer::Loc loc, UStr name, const Expr *expr)
     return add(name, symtab::Entry::createExprEntry(loc, id, expr));
 }
 
+std::pair<symtab::Entry *, bool>
+Symtab::addBuiltin(lexer::Loc loc, UStr name)
+{
+    // builtins are not subject to name mangling, the id is the name
+    auto added = add(name, symtab::Entry::createBuiltinEntry(loc, name));
+    added.first->setPredefinedFlag();
+    return added;
+}
+
 void
 Symtab::print(std::ostream &out)
 {
@@ -155,6 +174,8 @@ Symtab::print(std::ostream &out)
 	    out << item.first << ": " << item.second.getId() << ", ";
 	    if (item.second.expressionDeclaration()) {
 		out << item.second.expr;
+	    } else if (item.second.builtinDeclaration()) {
+		out << "builtin";
 	    } else {
 		out << item.second.type;
 	    }
@@ -168,6 +189,13 @@ Symtab::print(std::ostream &out)
 std::pair<symtab::Entry *, bool>
 Symtab::add(UStr name, symtab::Entry &&entry)
 {
+    // a user declaration replaces a predefined identifier, so builtins do
+    // not take names away from user code
+    auto found = scope.front()->find(name);
+    if (found != scope.front()->end() && found->second.predefined()) {
+	scope.front()->erase(found);
+    }
+
     if (scope.front()->contains(name)) {
 	auto &found = scope.front()->at(name);
 
@@ -33,6 +33,7 @@ class Symtab
 	static const symtab::Entry *type(UStr name, Scope inScope);
 	static const symtab::Entry *variable(UStr name, Scope inScope);
 	static const symtab::Entry *constant(UStr name, Scope inScope);
+	static const symtab::Entry *builtin(UStr name, Scope inScope);
 
 	static std::pair<symtab::Entry *, bool>
 	addDeclaration(lexer::Loc loc, UStr name, const Type *type);
@@ -46,6 +47,9 @@ class Symtab
 	static std::pair<symtab::Entry *, bool>
 	addExpression(lexer::Loc loc, UStr name, const Expr *expr);
 
+	static std::pair<symtab::Entry *, bool> addBuiltin(lexer::Loc loc,
+	                                                   UStr name);
+
 	static void print(std::ostream &out);
 
     private:
@@ -33,6 +33,7 @@ ArrayType::create(const Type *refType, std::size_t dim, bool constFlag)
     std::stringstream ss;
     ss << "array " << getArrayDimAndType(refType, dim);
     auto ty = ArrayType{refType, dim, constFlag, UStr::create(ss.str())};
+    std::lock_guard lock{typeMutex};
     return &*arraySet.insert(ty).first;
 }
 
@@ -23,6 +23,7 @@ const Type *
 AutoType::create(bool constFlag, UStr name)
 {
     auto ty = AutoType{constFlag, name};
+    std::lock_guard lock{typeMutex};
     return &*voidSet.insert(ty).first;
 }
 
@@ -26,6 +26,7 @@ EnumType::init()
 Type *
 EnumType::createIncomplete(UStr name, const Type *intType)
 {
+    std::lock_guard lock{typeMutex};
     static std::size_t count;
     auto id = count++;
 
@@ -44,12 +45,14 @@ EnumType::id() const
 const Type *
 EnumType::getConst() const
 {
+    std::lock_guard lock{typeMutex};
     return &enumConstMap.at(id_);
 }
 
 const Type *
 EnumType::getConstRemoved() const
 {
+    std::lock_guard lock{typeMutex};
     return &enumMap.at(id_);
 }
 
@@ -93,6 +96,7 @@ const Type *
 EnumType::complete(std::vector<UStr> &&constName,
                    std::vector<std::int64_t> &&constValue)
 {
+    std::lock_guard lock{typeMutex};
     constName_ = std::move(constName);
     constValue_ = std::move(constValue);
     isComplete_ = true;
@@ -27,6 +27,7 @@ FloatType::create(FloatKind floatKind, bool constFlag)
 {
     std::string str = floatKind == FLOAT_KIND ? "float" : "double";
     auto ty = FloatType{floatKind, constFlag, UStr::create(str)};
+    std::lock_guard lock{typeMutex};
     return &*fltSet.insert(ty).first;
 }
 
@@ -30,6 +30,7 @@ FunctionType::create(const Type *ret, std::vector<const Type *> &&param,
                      bool varg, bool constFlag, UStr alias)
 {
     auto ty = FunctionType{ret, std::move(param), varg, constFlag, alias};
+    std::lock_guard lock{typeMutex};
     return &*fnSet.insert(ty).first;
 }
 
@@ -33,6 +33,7 @@ IntegerType::create(std::size_t numBits, bool signed_, bool constFlag)
     std::stringstream ss;
     ss << (signed_ ? "i" : "u") << numBits;
     auto ty = IntegerType{numBits, signed_, constFlag, UStr::create(ss.str())};
+    std::lock_guard lock{typeMutex};
     return &*intSet.insert(ty).first;
 }
 
@@ -25,6 +25,7 @@ const Type *
 NullptrType::create(bool constFlag, UStr name)
 {
     auto ty = NullptrType{constFlag, name};
+    std::lock_guard lock{typeMutex};
     return &*nullptrSet.insert(ty).first;
 }
 
@@ -31,6 +31,7 @@ PointerType::create(const Type *refType, bool constFlag)
     std::stringstream ss;
     ss << "-> " << refType;
     auto ty = PointerType{refType, constFlag, UStr::create(ss.str())};
+    std::lock_guard lock{typeMutex};
     return &*pointerSet.insert(ty).first;
 }
 
@@ -12,7 +12,8 @@ static std::unordered_map<std::size_t, StructType> structConstSet;
 //------------------------------------------------------------------------------
 
 StructType::StructType(std::size_t id, UStr name, bool constFlag)
-    : Type{constFlag, name}, id_{id}, isComplete_{false}
+    : Type{constFlag, name}, id_{id}, isComplete_{false}, isPacked_{false},
+      alignment_{0}
 {
 }
 
@@ -26,6 +27,7 @@ StructType::init()
 Type *
 StructType::createIncomplete(UStr name)
 {
+    std::lock_guard lock{typeMutex};
     static std::size_t count;
     auto id = count++;
 
@@ -44,12 +46,14 @@ StructType::id() const
 const Type *
 StructType::getConst() const
 {
+    std::lock_guard lock{typeMutex};
     return &structConstSet.at(id());
 }
 
 const Type *
 StructType::getConstRemoved() const
 {
+    std::lock_guard lock{typeMutex};
     return &structSet.at(id());
 }
 
@@ -68,8 +72,10 @@ StructType::isStruct() const
 const Type *
 StructType::complete(std::vector<UStr> &&memberName,
                      std::vector<std::size_t> &&memberIndex,
-                     std::vector<const Type *> &&memberType)
+                     std::vector<const Type *> &&memberType, bool packed,
+                     std::size_t alignment)
 {
+    std::lock_guard lock{typeMutex};
     assert(memberIndex.size());
     assert(memberName.size() == memberIndex.size());
     assert(memberName.size() == memberType.size());
@@ -80,11 +86,15 @@ StructType::complete(std::vector<UStr> &&memberName,
 	constStructType.memberType_.push_back(memberType[i]->getConst());
     }
     constStructType.isComplete_ = true;
+    constStructType.isPacked_ = packed;
+    constStructType.alignment_ = alignment;
 
     memberName_ = std::move(memberName);
     memberIndex_ = std::move(memberIndex);
     memberType_ = std::move(memberType);
     isComplete_ = true;
+    isPacked_ = packed;
+    alignment_ = alignment;
     return this;
 }
 
@@ -128,6 +138,18 @@ StructType::memberIndex(UStr name) const
     return std::nullopt;
 }
 
+bool
+StructType::isPacked() const
+{
+    return isPacked_;
+}
+
+std::size_t
+StructType::alignment() const
+{
+    return alignment_;
+}
+
 std::size_t
 StructType::aggregateSize() const
 {
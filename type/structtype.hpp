@@ -12,6 +12,8 @@ class StructType : public Type
 	std::size_t id_;
 
 	bool isComplete_;
+	bool isPacked_;
+	std::size_t alignment_;
 	std::vector<UStr> memberName_;
 	std::vector<std::size_t> memberIndex_;
 	std::vector<const Type *> memberType_;
@@ -30,12 +32,15 @@ class StructType : public Type
 	bool isStruct() const override;
 	const Type *complete(std::vector<UStr> &&memberName,
 	                     std::vector<std::size_t> &&memberIndex,
-	                     std::vector<const Type *> &&memberType) override;
+	                     std::vector<const Type *> &&memberType,
+	                     bool packed, std::size_t alignment) override;
 	const std::vector<UStr> &memberName() const override;
 	const std::vector<std::size_t> &memberIndex() const override;
 	std::optional<std::size_t> memberIndex(UStr name) const override;
 	const std::vector<const Type *> &memberType() const override;
 	const Type *memberType(UStr name) const override;
+	bool isPacked() const override;
+	std::size_t alignment() const override;
 	std::size_t aggregateSize() const override;
 	const Type *aggregateType(std::size_t index) const override;
 };
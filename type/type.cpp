@@ -10,6 +10,8 @@
 
 namespace abc {
 
+std::recursive_mutex typeMutex;
+
 Type::Type(bool isConst, UStr name) : isConst{isConst}, name{name} {}
 
 bool
@@ -458,7 +460,7 @@ Type::isStruct() const
 
 const Type *
 Type::complete(std::vector<UStr> &&, std::vector<std::size_t> &&,
-               std::vector<const Type *> &&)
+               std::vector<const Type *> &&, bool, std::size_t)
 {
     if (isAlias() && getUnalias()->isStruct()) {
 	assert(0 && "Alias type can not be completed");
@@ -500,6 +502,18 @@ Type::memberType(UStr name) const
     return isAlias() ? getUnalias()->memberType(name) : nullptr;
 }
 
+bool
+Type::isPacked() const
+{
+    return isAlias() ? getUnalias()->isPacked() : false;
+}
+
+std::size_t
+Type::alignment() const
+{
+    return isAlias() ? getUnalias()->alignment() : 0;
+}
+
 std::ostream &
 operator<<(std::ostream &out, const Type *type)
 {
@@ -3,6 +3,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <mutex>
 #include <optional>
 #include <ostream>
 #include <vector>
@@ -88,18 +89,27 @@ class Type
 	virtual bool isStruct() const;
 	virtual const Type *complete(std::vector<UStr> &&memberName,
 	                             std::vector<std::size_t> &&memberIndex,
-	                             std::vector<const Type *> &&memberType);
+	                             std::vector<const Type *> &&memberType,
+	                             bool packed = false,
+	                             std::size_t alignment = 0);
 	virtual const std::vector<UStr> &memberName() const;
 	virtual const std::vector<std::size_t> &memberIndex() const;
 	virtual std::optional<std::size_t> memberIndex(UStr name) const;
 	virtual const std::vector<const Type *> &memberType() const;
 	virtual const Type *memberType(UStr name) const;
+	virtual bool isPacked() const;
+	// explicit alignment requested with 'alignas', otherwise 0
+	virtual std::size_t alignment() const;
 
 	friend std::ostream &operator<<(std::ostream &out, const Type *type);
 };
 
 std::ostream &operator<<(std::ostream &out, const Type *type);
 
+// Guards the sets of created types. With -fpipelined-codegen types are also
+// created and looked up by the code generation thread.
+extern std::recursive_mutex typeMutex;
+
 } // namespace abc
 
 #endif // TYPE_TYPE_HPP
@@ -25,6 +25,7 @@ TypeAlias::init()
 const Type *
 TypeAlias::create(UStr name, const Type *type)
 {
+    std::lock_guard lock{typeMutex};
     static std::size_t count;
     auto id = count++;
 
@@ -49,12 +50,14 @@ TypeAlias::getUnalias() const
 const Type *
 TypeAlias::getConst() const
 {
+    std::lock_guard lock{typeMutex};
     return &aliasConstSet.at(id);
 }
 
 const Type *
 TypeAlias::getConstRemoved() const
 {
+    std::lock_guard lock{typeMutex};
     return &aliasSet.at(id);
 }
 
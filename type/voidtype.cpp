@@ -24,6 +24,7 @@ const Type *
 VoidType::create(bool constFlag, UStr name)
 {
     auto ty = VoidType{constFlag, name};
+    std::lock_guard lock{typeMutex};
     return &*voidSet.insert(ty).first;
 }
 
@@ -0,0 +1,62 @@
+#ifndef UTIL_BOUNDEDQUEUE_HPP
+#define UTIL_BOUNDEDQUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace abc {
+
+// Queue for passing items from a producer to a consumer thread. push() blocks
+// while the queue is full and pop() while it is empty. After close() pop()
+// returns the remaining items and then std::nullopt.
+template <typename T>
+class BoundedQueue
+{
+    public:
+	BoundedQueue(std::size_t capacity) : capacity{capacity} {}
+
+	void
+	push(T &&value)
+	{
+	    std::unique_lock lock{mutex};
+	    notFull.wait(lock, [this] { return item.size() < capacity; });
+	    item.push_back(std::move(value));
+	    notEmpty.notify_one();
+	}
+
+	void
+	close()
+	{
+	    std::lock_guard lock{mutex};
+	    closed = true;
+	    notEmpty.notify_all();
+	}
+
+	std::optional<T>
+	pop()
+	{
+	    std::unique_lock lock{mutex};
+	    notEmpty.wait(lock, [this] { return !item.empty() || closed; });
+	    if (item.empty()) {
+		return std::nullopt;
+	    }
+	    auto value = std::move(item.front());
+	    item.pop_front();
+	    notFull.notify_one();
+	    return value;
+	}
+
+    private:
+	const std::size_t capacity;
+	std::deque<T> item;
+	bool closed = false;
+	std::mutex mutex;
+	std::condition_variable notFull, notEmpty;
+};
+
+} // namespace abc
+
+#endif // UTIL_BOUNDEDQUEUE_HPP
@@ -1,3 +1,4 @@
+#include <mutex>
 #include <set>
 
 #include "ustr.hpp"
@@ -5,14 +6,21 @@
 namespace abc {
 
 static std::set<std::string> ustrSet;
+// strings are also created by the code generation thread of
+// -fpipelined-codegen
+static std::mutex ustrMutex;
 
-UStr::UStr() : c_str_{nullptr}, len{0} {}
-
-UStr::UStr(const std::string &s)
-    : c_str_{ustrSet.insert(s).first->c_str()}, len{s.length()}
+static const char *
+insert(const std::string &s)
 {
+    std::lock_guard lock{ustrMutex};
+    return ustrSet.insert(s).first->c_str();
 }
 
+UStr::UStr() : c_str_{nullptr}, len{0} {}
+
+UStr::UStr(const std::string &s) : c_str_{insert(s)}, len{s.length()} {}
+
 void
 UStr::init()
 {